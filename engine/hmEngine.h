@@ -0,0 +1,2459 @@
+/*
+ * hmEngine - the Holy Mackerel LPG engine, free of any Disting NT dependency
+ *
+ * Everything between the input sample and the output sample lives here:
+ * the vactrol model, SVF, FX, modal body, trigger and onset detection, plus
+ * the numeric-safety and diagnostic hooks they carry. Header-only, so the
+ * NT plugin stays a single translation unit; hmEngineApi.h wraps it in a
+ * C API for batch processing outside the module.
+ *
+ * Build flags (all optional): HM_PROFILE, HM_HEALTH, HM_TRACE, HM_CPU_HZ.
+ */
+
+#pragma once
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+
+#if !defined(__arm__)
+#include <chrono>
+#endif
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+#ifndef ARRAY_SIZE
+#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
+#endif
+
+static constexpr float PI = 3.14159265358979323846f;
+static constexpr float TWO_PI = 6.28318530717958647692f;
+
+// ============================================================================
+// UTILITY FUNCTIONS
+// ============================================================================
+
+static inline float clampf(float x, float lo, float hi) {
+    return x < lo ? lo : (x > hi ? hi : x);
+}
+
+static inline float lerpf(float a, float b, float t) {
+    return a + (b - a) * clampf(t, 0.0f, 1.0f);
+}
+
+static inline float fast_tanh(float x) {
+    if (x < -3.0f) return -1.0f;
+    if (x > 3.0f) return 1.0f;
+    float x2 = x * x;
+    return x * (27.0f + x2) / (27.0f + 9.0f * x2);
+}
+
+// tan(x) for 0 <= x <= 0.49*pi - the SVF prewarp up to 0.49*sr. Written as
+// x * P(x^2) / (pi^2/4 - x^2), so the pole is exact and P only has to fit
+// a smooth curve falling from pi^2/4 to 2. Quadratic P, minimax relative
+// error 4e-5 (well under a cent of cutoff) at the cost of fast_tanh.
+static inline float fast_tan(float x) {
+    float x2 = x * x;
+    float p = 2.46730317f + x2 * (-0.176852237f + x2 * -0.0050564034f);
+    return x * p / (2.46740110f - x2);
+}
+
+static inline float soft_saturate(float x, float knee) {
+    float ax = fabsf(x);
+    if (ax < knee) return x;
+    float sign = x > 0.0f ? 1.0f : -1.0f;
+    return sign * (knee + (1.0f - knee) * fast_tanh((ax - knee) / (1.0f - knee)));
+}
+
+// ============================================================================
+// SAMPLE RATE - Coefficients re-derived from their time constants per rate
+//
+// The per-sample constants below were voiced at 48kHz. Each one stands for
+// a time constant, so setSampleRate() re-derives it for the running rate:
+// a multiplier c becomes c^(48000/sr), a smoothing amount a becomes
+// 1 - (1-a)^(48000/sr), and a count of samples becomes the same time in
+// samples. At 48kHz every derivation returns the tuned value bit for bit.
+//
+// Control-rate work (CV, body damping, NaN checks, and the Eco and CV mode
+// envelopes and coefficients) runs at fixed rates in Hz instead of every N
+// samples, so it costs the same per second at any rate. Everything per
+// sample scales with the rate: the filter, body and FX, and in Standard
+// and HQ also the vactrol envelope (one expf) and the SVF coefficient,
+// which is what those tiers keep over Eco. That is most of the work, so a
+// channel costs about 2x at 96kHz in every tier (hmhost srcheck).
+// ============================================================================
+
+static constexpr float kTunedRate = 48000.0f;
+
+// Per-sample values at kTunedRate, and what they amount to
+static constexpr float kCutoffSmoothing = 0.35f;      // SVF cutoff smoother: 48us time constant
+static constexpr float kClosedStateLeak = 0.995f;     // SVF state bleed while the gate is shut: 4.2ms
+static constexpr float kDCBlockerPole = 0.997f;       // Output DC blocker: 6.9ms, ~23Hz
+static constexpr float kTubeGridDecay = 0.9998f;      // Tube grid-blocking recovery: 104ms
+static constexpr float kTubeDCPole = 0.995f;          // Tube DC blocker: 4.2ms, ~38Hz
+static constexpr float kTriggerVisualDecay = 0.96f;   // Trigger flash on the display: 0.5ms
+
+// Cutoff the filter gate reaches fully open at brightness 1, in Hz, so a
+// given gate sounds equally bright at every rate (0.45*sr above 48kHz
+// stays reserved for Bright above 1)
+static constexpr float kFullGateCutoff = 0.45f * kTunedRate;
+
+// Trigger detector timing, in seconds
+static constexpr float kTriggerRearmTime = 16.0f / kTunedRate;   // Must read low this long to re-arm
+static constexpr float kTriggerLockoutTime = 0.015f;
+
+// Control rates. A control block is the run of samples between CV
+// updates; the plugin renders and checks one control block at a time, in
+// scratch buffers of kMaxControlBlock samples.
+static constexpr float kControlRateHz = 1500.0f;      // CV, body damping, NaN checks (32 samples at 48kHz)
+static constexpr float kCVEnvelopeRateHz = 3000.0f;   // CV-mode vactrol (16 samples at 48kHz)
+static constexpr float kEcoRateHz = 12000.0f;         // Eco vactrol + SVF coefficients (4 samples at 48kHz)
+static constexpr float kMaxSampleRate = 192000.0f;    // Highest rate the control rates hold at
+static constexpr int kMaxControlBlock = (int)(kMaxSampleRate / kControlRateHz);   // 128 samples
+
+// Samples between updates at rateHz, 1..kMaxControlBlock. Only a rate
+// above kMaxSampleRate reaches the clamp, and updates faster there.
+static inline int controlInterval(float rateHz, float sr) {
+    int n = (int)(sr / rateHz + 0.5f);
+    return n < 1 ? 1 : (n > kMaxControlBlock ? kMaxControlBlock : n);
+}
+
+// `seconds` in whole samples at sr, at least one
+static inline int samplesFor(float seconds, float sr) {
+    int n = (int)(seconds * sr + 0.5f);
+    return n < 1 ? 1 : n;
+}
+
+// Multiplier tuned per sample at kTunedRate, applied once per `steps`
+// samples at sr - the same time constant
+static inline float rateCoef(float tuned, float sr, int steps = 1) {
+    float exponent = (float)steps * (kTunedRate / sr);
+    return exponent == 1.0f ? tuned : powf(tuned, exponent);
+}
+
+// One-pole smoothing amount (x += (target - x) * amount), likewise
+static inline float rateSmoothing(float tuned, float sr, int steps = 1) {
+    float exponent = (float)steps * (kTunedRate / sr);
+    return exponent == 1.0f ? tuned : 1.0f - powf(1.0f - tuned, exponent);
+}
+
+// ============================================================================
+// NUMERIC SAFETY - Flush-to-zero for step() + once-per-block state checks
+//
+// Denormals are flushed in hardware for the duration of step(), so the
+// kernels need no per-sample denormal guards. NaN/inf detection runs once
+// per control block on each channel's state rather than on every output
+// sample: anything non-finite that reached the output path leaves the DC
+// blocker state non-finite, so checking the state catches it, and the
+// whole block is silenced before it reaches the bus.
+// ============================================================================
+
+// False for NaN and +-inf. Relies on IEEE semantics - never build with -ffast-math.
+static inline bool isFiniteF(float x) {
+    return (x - x) == 0.0f;
+}
+
+// Sets FTZ (and DAZ where it is a separate bit) and restores the caller's
+// mode on scope exit, so the host's FP environment is left as it was found.
+class FlushDenormalsScope {
+public:
+#if defined(__arm__) && defined(__VFP_FP__) && !defined(__SOFTFP__)
+    FlushDenormalsScope() {
+        __asm__ volatile("vmrs %0, fpscr" : "=r"(saved));
+        uint32_t fz = saved | (1u << 24);       // FPSCR.FZ - flushes inputs and results
+        __asm__ volatile("vmsr fpscr, %0" : : "r"(fz));
+    }
+    ~FlushDenormalsScope() { __asm__ volatile("vmsr fpscr, %0" : : "r"(saved)); }
+#elif defined(__SSE__)
+    FlushDenormalsScope() : saved(_mm_getcsr()) { _mm_setcsr(saved | 0x8040u); }  // FTZ | DAZ
+    ~FlushDenormalsScope() { _mm_setcsr(saved); }
+#else
+    FlushDenormalsScope() {}
+#endif
+private:
+    FlushDenormalsScope(const FlushDenormalsScope&);
+    FlushDenormalsScope& operator=(const FlushDenormalsScope&);
+    uint32_t saved = 0;
+};
+
+// ============================================================================
+// CYCLE TIMER - Shared by the profiler and the load governor
+//
+// On the Cortex-M7 this reads the DWT cycle counter (a single bus read).
+// On the host it reads a steady nanosecond clock. Nothing touches the DWT
+// until profTimerInit() is called, so builds that never profile and never
+// enable the governor leave the debug block alone.
+// ============================================================================
+
+// Core clock, used to turn DWT cycles into a fraction of the block deadline
+#ifndef HM_CPU_HZ
+#define HM_CPU_HZ 600000000u
+#endif
+
+#if defined(__arm__)
+static volatile uint32_t* const kDWT_CTRL   = (volatile uint32_t*)0xE0001000;
+static volatile uint32_t* const kDWT_CYCCNT = (volatile uint32_t*)0xE0001004;
+static volatile uint32_t* const kDWT_LAR    = (volatile uint32_t*)0xE0001FB0;
+static volatile uint32_t* const kDEMCR      = (volatile uint32_t*)0xE000EDFC;
+
+static inline void profTimerInit() {
+    *kDEMCR |= (1u << 24);      // TRCENA - power the DWT block
+    *kDWT_LAR = 0xC5ACCE55;     // M7 DWT is write-locked out of reset
+    *kDWT_CTRL |= 1u;           // CYCCNTENA - counter is free-running, never reset
+}
+static inline uint32_t profTimerRead() { return *kDWT_CYCCNT; }
+static constexpr float kProfTicksPerSecond = (float)HM_CPU_HZ;
+static constexpr const char* kProfTickUnit = "cyc";
+#else
+static inline void profTimerInit() {}
+static inline uint32_t profTimerRead() {
+    // Wraps every ~4.3s - differences stay correct for any block length
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+static constexpr float kProfTicksPerSecond = 1.0e9f;
+static constexpr const char* kProfTickUnit = "ns";
+#endif
+
+// ============================================================================
+// PROFILING - Per-stage timing of step() (build with -DHM_PROFILE=1)
+//
+// Each probe is a "lap": the time since the previous probe is charged to
+// the named stage, so one timer read per stage boundary covers the whole
+// block. With HM_PROFILE=0 (the default) every probe compiles to nothing.
+// ============================================================================
+
+#ifndef HM_PROFILE
+#define HM_PROFILE 0
+#endif
+
+enum ProfileStage {
+    PROF_TRIGGER = 0,   // Schmitt trigger scan
+    PROF_CV,            // CV sampling + parameter update
+    PROF_ENVELOPE,      // Vactrol decay + transfer curves
+    PROF_FILTER,        // SVF + VCA
+    PROF_BODY,          // Modal body resonators
+    PROF_FX,            // FX, DC blocker, safety limiter
+    PROF_OUTPUT,        // Bus writes + envelope output
+    kNumProfStages
+};
+
+#if HM_PROFILE
+
+#define HM_PROF(x) x
+
+// Running min/avg/max per stage, normalised to ticks per sample so blocks
+// of different sizes compare directly. Row kNumProfStages is the whole step().
+class StageProfiler {
+public:
+    static constexpr int kNumRows = kNumProfStages + 1;
+
+    void reset() {
+        for (int s = 0; s < kNumRows; s++) {
+            minPerSample[s] = 1.0e30f;
+            maxPerSample[s] = 0.0f;
+            sumTicks[s] = 0;
+        }
+        sumFrames = 0;
+        numBlocks = 0;
+    }
+
+    void beginBlock() {
+        for (int s = 0; s < kNumProfStages; s++) blockTicks[s] = 0;
+        blockStart = lastLap = profTimerRead();
+    }
+
+    void lap(int stage) {
+        uint32_t now = profTimerRead();
+        blockTicks[stage] += now - lastLap;
+        lastLap = now;
+    }
+
+    void endBlock(int numFrames) {
+        blockTicks[kNumProfStages] = profTimerRead() - blockStart;
+        float invFrames = 1.0f / (float)numFrames;
+        for (int s = 0; s < kNumRows; s++) {
+            float perSample = (float)blockTicks[s] * invFrames;
+            if (perSample < minPerSample[s]) minPerSample[s] = perSample;
+            if (perSample > maxPerSample[s]) maxPerSample[s] = perSample;
+            sumTicks[s] += blockTicks[s];
+        }
+        sumFrames += (uint64_t)numFrames;
+        numBlocks++;
+    }
+
+    uint32_t getNumBlocks() const { return numBlocks; }
+    float getMin(int row) const { return numBlocks ? minPerSample[row] : 0.0f; }
+    float getMax(int row) const { return maxPerSample[row]; }
+    float getAvg(int row) const {
+        return sumFrames ? (float)((double)sumTicks[row] / (double)sumFrames) : 0.0f;
+    }
+
+private:
+    uint32_t blockTicks[kNumRows] = {};
+    uint32_t blockStart = 0;
+    uint32_t lastLap = 0;
+    float minPerSample[kNumRows] = {};
+    float maxPerSample[kNumRows] = {};
+    uint64_t sumTicks[kNumRows] = {};
+    uint64_t sumFrames = 0;
+    uint32_t numBlocks = 0;
+};
+
+#else
+#define HM_PROF(x)
+#endif
+
+// ============================================================================
+// DSP HEALTH COUNTERS - How often the silent recovery paths fire
+//
+// The NaN counts come from the per-chunk recovery: once per control block
+// LPGChannel::recoverChunk() checks the channel's state (filter, FX, body,
+// DC blocker, vactrol) for non-finite values, and counts only when it has
+// to reset. The SVF state clamp costs one branchless compare per sample;
+// the trigger counts sit in the Schmitt trigger's edge logic. Build with
+// -DHM_HEALTH=0 to remove them entirely.
+// ============================================================================
+
+#ifndef HM_HEALTH
+#define HM_HEALTH 1
+#endif
+
+#if HM_HEALTH
+#define HM_HEALTH_COUNT(x) x
+#else
+#define HM_HEALTH_COUNT(x)
+#endif
+
+enum HealthEvent {
+    HEALTH_FILTER_NAN = 0,  // SVF state non-finite at a chunk check → filter reset
+    HEALTH_OUTPUT_RESET,    // Any channel state non-finite at a chunk check → chunk silenced, signal path reset
+    HEALTH_STATE_CLAMP,     // Samples where SVF s1/s2 hit the ±4 energy limit
+    HEALTH_TRIG_LOCKOUT,    // Trigger edges dropped inside the 15ms lockout
+    HEALTH_TRIG_DISARMED,   // Trigger edges dropped before the Schmitt re-armed
+    kNumHealthEvents
+};
+
+static const char* const healthEventNames[kNumHealthEvents] = {
+    "FILTER NAN", "OUT RESET", "S1/S2 CLAMP", "TRIG LOCKOUT", "TRIG DISARMED"
+};
+
+struct HealthCounters {
+    uint32_t count[kNumHealthEvents] = {};
+};
+
+// ============================================================================
+// STATE TRACE - Decimated, trigger-armed ring buffer (build with -DHM_TRACE=1)
+//
+// Records the left channel's internal state every `decimation` samples into
+// a fixed ring in DRAM. While armed the ring runs continuously; the first
+// trigger after arming starts the post-trigger countdown, and once the
+// window is full the trace freezes until re-armed. A quarter of the window
+// is kept from before the trigger. Per sample cost: one decrement + branch.
+// ============================================================================
+
+#ifndef HM_TRACE
+#define HM_TRACE 0
+#endif
+
+#ifndef HM_TRACE_LENGTH
+#define HM_TRACE_LENGTH 2048
+#endif
+
+#ifndef HM_TRACE_DECIMATION
+#define HM_TRACE_DECIMATION 4
+#endif
+
+enum TraceField {
+    TRACE_VACTROL = 0,      // vactrolState
+    TRACE_CUTOFF,           // smoothedCutoff (Hz)
+    TRACE_FILTER_GATE,      // filterGate
+    TRACE_VCA_GATE,         // vcaGate (after dampening)
+    TRACE_S1,               // SVF state s1
+    TRACE_S2,               // SVF state s2
+    TRACE_MEMORY_SCALE,     // memoryDecayScale
+    TRACE_OUTPUT,           // channel output
+    kNumTraceFields
+};
+
+static const char* const traceFieldNames[kNumTraceFields] = {
+    "vactrolState", "smoothedCutoff", "filterGate", "vcaGate",
+    "s1", "s2", "memoryDecayScale", "output"
+};
+
+struct TraceFrame {
+    float v[kNumTraceFields];
+};
+
+#if HM_TRACE
+
+#define HM_TRACE_DO(x) x
+
+enum TraceState {
+    TRACE_IDLE = 0,
+    TRACE_ARMED,        // Ring running, waiting for a trigger
+    TRACE_TRIGGERED,    // Counting down the post-trigger part of the window
+    TRACE_DONE          // Frozen - read it, then re-arm
+};
+
+class StateTrace {
+public:
+    void init(TraceFrame* memory, int numFrames) {
+        frames = memory;
+        length = numFrames;
+        state = TRACE_IDLE;
+    }
+    
+    void setDecimation(int d) { decimation = d < 1 ? 1 : d; }
+    int getDecimation() const { return decimation; }
+    
+    void arm() {
+        writePos = 0;
+        filled = 0;
+        totalWritten = 0;
+        triggerOrdinal = 0;
+        decimCount = 1;
+        state = TRACE_ARMED;
+    }
+    
+    void onTrigger() {
+        if (state != TRACE_ARMED) return;
+        state = TRACE_TRIGGERED;
+        triggerOrdinal = totalWritten;
+        postRemaining = length - length / 4;
+    }
+    
+    // Call once per sample; true when this sample should be recorded
+    bool tick() {
+        if (state == TRACE_IDLE || state == TRACE_DONE) return false;
+        if (--decimCount > 0) return false;
+        decimCount = decimation;
+        return true;
+    }
+    
+    // Slot for the sample tick() accepted
+    TraceFrame& nextFrame() {
+        TraceFrame& f = frames[writePos];
+        if (++writePos == length) writePos = 0;
+        if (filled < length) filled++;
+        totalWritten++;
+        if (state == TRACE_TRIGGERED && --postRemaining <= 0) {
+            state = TRACE_DONE;
+        }
+        return f;
+    }
+    
+    TraceState getState() const { return state; }
+    int getNumFrames() const { return filled; }
+    
+    // Oldest first
+    const TraceFrame& getFrame(int i) const {
+        int start = (filled < length) ? 0 : writePos;
+        int idx = start + i;
+        if (idx >= length) idx -= length;
+        return frames[idx];
+    }
+    
+    // Index of the first frame at/after the trigger, -1 if not triggered
+    int getTriggerIndex() const {
+        if (state != TRACE_TRIGGERED && state != TRACE_DONE) return -1;
+        return (int)(triggerOrdinal - (totalWritten - (uint32_t)filled));
+    }
+    
+private:
+    TraceFrame* frames = nullptr;
+    int length = 0;
+    int decimation = HM_TRACE_DECIMATION;
+    int decimCount = 1;
+    int writePos = 0;
+    int filled = 0;
+    int postRemaining = 0;
+    uint32_t totalWritten = 0;
+    uint32_t triggerOrdinal = 0;
+    TraceState state = TRACE_IDLE;
+};
+
+#else
+#define HM_TRACE_DO(x)
+#endif
+
+// ============================================================================
+// MATERIAL MODES
+// ============================================================================
+
+enum MaterialMode {
+    MATERIAL_NATURAL = 0,
+    MATERIAL_HARD = 1,
+    MATERIAL_SOFT = 2
+};
+
+// Attack times in seconds
+static const float kMaterialAttackTime[3] = {
+    0.005f,     // Natural - 5ms (wood/organic)
+    0.0005f,    // Hard - 0.5ms (metal/glass — instant, sharp transient)
+    0.020f      // Soft - 20ms (rubber/felt — rounded, gentle)
+};
+
+// Decay multipliers — how long the material rings
+// Hard materials RING LONGER (metal sustains), soft materials ABSORB (rubber deadens)
+static const float kMaterialDecayMult[3] = {
+    1.0f,       // Natural - baseline
+    1.4f,       // Hard - metal/glass RINGS, longer sustain
+    0.7f        // Soft - rubber/felt absorbs, shorter sustain
+};
+
+// Filter brightness (affects cutoff range)
+// Hard = bright and shimmery, Soft = dark and thuddy
+static const float kMaterialBrightness[3] = {
+    1.0f,       // Natural - full range
+    1.8f,       // Hard - bright, lots of upper harmonics
+    0.35f       // Soft - dark, muted
+};
+
+// Vactrol level-dependent decay modulation
+// LOW values = uniform/ringing decay (metal), HIGH = fast initial drop (thud)
+static const float kMaterialVactrolMod[3] = {
+    2.5f,       // Natural - balanced thwack and body
+    1.2f,       // Hard - low modulation = even ring, shimmer sustain
+    4.0f        // Soft - high modulation = fast thwack, quick deadening
+};
+
+// Filter transfer curve exponent (from single vactrol state)
+// LOW = filter stays open (bright ringing), HIGH = filter closes fast (dark thud)
+static const float kMaterialFilterExponent[3] = {
+    1.8f,       // Natural - classic LPG pluck
+    1.2f,       // Hard - filter stays open = bright metallic ring
+    2.8f        // Soft - filter closes fast = dark, muted, felt-like
+};
+
+// ============================================================================
+// FX MODES
+// ============================================================================
+
+enum FXMode {
+    FX_CLEAN = 0,
+    FX_TUBE = 1,
+    FX_SCREAMER = 2,
+    FX_GRIT = 3
+};
+
+// ============================================================================
+// QUALITY TIERS - Trade CPU for fidelity
+//
+// Standard is the reference sound and the default. Eco runs the envelope
+// and SVF coefficients at kEcoRateHz (every 4 samples at 48kHz); HQ runs
+// the FX stage 2x oversampled. The load governor can drop the tier below
+// the one chosen on the Performance page, never above it. host/hmfuzz
+// checks every tier against the per-sample reference in hmReference.h.
+// ============================================================================
+
+enum QualityTier {
+    QUALITY_ECO = 0,
+    QUALITY_STANDARD = 1,
+    QUALITY_HQ = 2
+};
+
+// ============================================================================
+// 2X OVERSAMPLER - Linear-phase halfband pair for the HQ FX stage
+//
+// Kaiser-windowed halfband (beta 7.5), 8 tap pairs per polyphase branch.
+// Flat (+-0.002dB) to 0.35*fs; images and aliases from 0.65*fs up are
+// held below -74dB.
+// Interpolation and decimation each delay by kHalfbandTaps base-rate
+// samples, so HQ adds 16 samples (~0.33ms at 48kHz) while FX is active.
+// ============================================================================
+
+static constexpr int kHalfbandTaps = 8;
+static constexpr int kOversampleLatency = 2 * kHalfbandTaps;   // Base-rate samples, a power of two
+
+// Odd-phase coefficients (taps at +-0.5, +-1.5, ... base-rate samples).
+// The even phase is a pure delay; 2 * sum(a) = 1 gives unity passband gain.
+static const float kHalfbandCoef[kHalfbandTaps] = {
+    0.628013268f, -0.187519092f, 0.089826457f, -0.045139977f,
+    0.021311594f, -0.008779012f, 0.002853483f, -0.000566720f
+};
+
+class Oversampler2x {
+public:
+    void reset() {
+        memset(upHist, 0, sizeof(upHist));
+        memset(evenHist, 0, sizeof(evenHist));
+        memset(oddHist, 0, sizeof(oddHist));
+    }
+
+    // One base-rate sample in, two high-rate samples out (in time order)
+    void upsample(float x, float& even, float& odd) {
+        memmove(upHist + 1, upHist, sizeof(upHist) - sizeof(float));
+        upHist[0] = x;
+
+        even = upHist[kHalfbandTaps];
+        float acc = 0.0f;
+        for (int k = 1; k <= kHalfbandTaps; k++) {
+            acc += kHalfbandCoef[k - 1] * (upHist[kHalfbandTaps - k] + upHist[kHalfbandTaps - 1 + k]);
+        }
+        odd = acc;
+    }
+
+    // Two high-rate samples in, one base-rate sample out
+    float downsample(float even, float odd) {
+        memmove(evenHist + 1, evenHist, sizeof(evenHist) - sizeof(float));
+        memmove(oddHist + 1, oddHist, sizeof(oddHist) - sizeof(float));
+        evenHist[0] = even;
+        oddHist[0] = odd;
+
+        float acc = 0.0f;
+        for (int k = 1; k <= kHalfbandTaps; k++) {
+            acc += kHalfbandCoef[k - 1] * (oddHist[kHalfbandTaps - k + 1] + oddHist[kHalfbandTaps + k]);
+        }
+        return 0.5f * (evenHist[kHalfbandTaps] + acc);
+    }
+
+private:
+    float upHist[2 * kHalfbandTaps] = {};
+    float evenHist[kHalfbandTaps + 1] = {};
+    float oddHist[2 * kHalfbandTaps + 1] = {};
+};
+
+// ============================================================================
+// LPG FILTER — Buchla 292-inspired SVF
+// 
+// Clean SVF with resonance that preserves bass through bandpass mixing
+// and makeup gain. NO level-dependent gain compensation (which caused
+// the double-hit artifact in the "Smile Pass" era).
+// ============================================================================
+
+class BuchlaLPGFilter {
+public:
+    void setSampleRate(float sr) {
+        sampleRate = sr;
+        maxCutoff = sr * 0.45f;
+        smoothCoef = rateSmoothing(kCutoffSmoothing, sr);
+        stateLeak = rateCoef(kClosedStateLeak, sr);
+        ecoInterval = controlInterval(kEcoRateHz, sr);
+        // ecoInterval smoothing steps in one
+        ecoSmoothCoef = rateSmoothing(kCutoffSmoothing, sr, ecoInterval);
+    }
+    
+    void setResonance(float res) {
+        resonance = clampf(res, 0.0f, 1.0f);
+        
+        // Q range: 0.5 (gentle) to 25 (self-oscillation territory)
+        float q = 0.5f + res * res * 24.5f;
+        k = 1.0f / q;
+        
+        // Resonance makeup gain — compensates for the SVF's LP output
+        // losing broadband energy at high Q (energy concentrates at resonant peak).
+        // This is STATIC per resonance setting, NOT level-dependent.
+        // Safe because it doesn't change during decay (unlike the old Smile Pass).
+        if (res > 0.15f) {
+            float r = res - 0.15f;
+            resMakeupGain = 1.0f + r * r * 4.0f;  // Aggressive makeup at high res
+        } else {
+            resMakeupGain = 1.0f;
+        }
+        
+        // How much bandpass to mix in — the resonant peak itself
+        // At high resonance the BP is where all the action is
+        bpMixAmount = res * res * 0.5f;
+        
+        // Eco: the held denominator depends on k. Refresh it rather than
+        // forcing an early update, which would also step the cutoff smoother
+        // (setParams() runs every chunk while CV is patched).
+        heldInvDen = 1.0f / (1.0f + heldG * (heldG + 2.0f * k));
+    }
+    
+    void setBrightness(float bright) {
+        brightness = clampf(bright, 0.1f, 2.0f);
+    }
+    
+    void setQuality(QualityTier tier) {
+        quality = tier;
+        coefCountdown = 0;  // Eco: recompute on the next sample
+    }
+    
+    float process(float input, float filterGate, float vcaGate) {
+        // At very low resonance, blend toward bypass for clean tone
+        float bypassMix = (resonance < 0.1f) ? (1.0f - resonance / 0.1f) * 0.5f : 0.0f;
+        
+        float g, hp;
+        if (quality == QUALITY_ECO) {
+            // Eco: coefficients held for ecoInterval samples. The smoother
+            // takes ecoInterval steps at once so its time constant matches.
+            if (--coefCountdown <= 0) {
+                coefCountdown = ecoInterval;
+                smoothedCutoff += (targetCutoffFor(filterGate) - smoothedCutoff) * ecoSmoothCoef;
+                float w = TWO_PI * smoothedCutoff / sampleRate;
+                heldG = fmaxf(fast_tan(w * 0.5f), 0.0001f);
+                heldInvDen = 1.0f / (1.0f + heldG * (heldG + 2.0f * k));
+            }
+            g = heldG;
+            hp = (input - (2.0f * k + g) * s1 - s2) * heldInvDen;
+        } else {
+            g = computeCoefficient(filterGate);
+            hp = (input - (2.0f * k + g) * s1 - s2) / (1.0f + g * (g + 2.0f * k));
+        }
+        
+        // Two-pole SVF
+        float bp = g * hp + s1;
+        float lp = g * bp + s2;
+        
+        // Update state with gentle saturation
+        s1 = soft_saturate(g * hp + bp, 0.9f);
+        s2 = soft_saturate(g * bp + lp, 0.9f);
+        
+        // Hard energy limit - prevents accumulation during rapid retriggers
+        // that caused crash after ~8 triggers in v7.0
+        // (clampf compiles to selects and lets NaN through to recoverIfInvalid())
+        HM_HEALTH_COUNT(clampHits += (uint32_t)((fabsf(s1) > 4.0f) | (fabsf(s2) > 4.0f)));
+        s1 = clampf(s1, -4.0f, 4.0f);
+        s2 = clampf(s2, -4.0f, 4.0f);
+        
+        // When gate is very low, gently decay filter state. Blended rather
+        // than selected - compilers turn `? stateLeak : 1.0f` back into a
+        // branch around the multiply. Both ends are exact: 1 while the gate
+        // is open, stateLeak below it.
+        float closed = (float)(vcaGate < 0.01f);
+        float leak = 1.0f + closed * (stateLeak - 1.0f);
+        s1 *= leak;
+        s2 *= leak;
+        
+        // =====================================================
+        // LPG OUTPUT STAGE — Clean and authentic
+        // =====================================================
+        //
+        // In the Buchla 292, the vactrol controls a simple LP filter
+        // and VCA in tandem. There is NO bass boost, no sparkle injection,
+        // no "smile pass" compensation. The bass that survives as the
+        // filter closes does so naturally — because it's below cutoff.
+        //
+        // CRITICAL FIX (v7.2.0): The old "Smile Pass" had a dynamic bass
+        // boost that INCREASED gain as the filter closed, creating a
+        // second amplitude peak 3-5ms after trigger that the ear heard
+        // as a double-hit. Removing it gives monotonic decay = single hit.
+        
+        // Base lowpass output + resonant character from bandpass
+        // The BP mix adds the resonant peak back in — this is where the
+        // "wild" resonance sound lives. Static mix amount per resonance
+        // setting, NOT modulated by gate level (which caused double-hit).
+        float filtered = lp + bp * bpMixAmount;
+        
+        // Apply VCA — this is the ONLY amplitude control
+        float output = filtered * vcaGate;
+        
+        // Apply resonance makeup
+        output *= resMakeupGain;
+        
+        // Blend toward clean bypass at very low resonance
+        if (bypassMix > 0.0f) {
+            float cleanPath = input * vcaGate;
+            output = lerpf(output, cleanPath, bypassMix);
+        }
+        
+        // Soft clip to prevent digital overs
+        output = soft_saturate(output, 0.95f);
+        
+        lastHP = hp;
+        lastBP = bp;
+        return output;
+    }
+    
+    // Raw SVF responses of the last sample, before the VCA
+    float getHighpass() const { return lastHP; }
+    float getBandpass() const { return lastBP; }
+    float getCutoff() const { return smoothedCutoff; }    // Hz, after smoothing
+    void reset() { s1 = s2 = lastHP = lastBP = 0.0f; smoothedCutoff = 20.0f; }
+    
+    // NaN protection - if anything went sideways since the last check,
+    // reset cleanly. Called once per chunk by LPGChannel::recoverChunk().
+    bool recoverIfInvalid() {
+        if (isFiniteF(s1 + s2 + smoothedCutoff)) return false;
+        reset();
+        HM_HEALTH_COUNT(nanResets++);
+        return true;
+    }
+    
+    void addHealth(HealthCounters& h) const {
+        h.count[HEALTH_FILTER_NAN] += nanResets;
+        h.count[HEALTH_STATE_CLAMP] += clampHits;
+    }
+    
+    void fillTrace(TraceFrame& f) const {
+        f.v[TRACE_CUTOFF] = smoothedCutoff;
+        f.v[TRACE_S1] = s1;
+        f.v[TRACE_S2] = s2;
+    }
+    
+    // Partially dampen filter state on retrigger to prevent energy accumulation
+    // from rapid repeated triggers causing high-pitch blowup
+    void dampStateOnRetrigger() {
+        s1 *= 0.5f;
+        s2 *= 0.5f;
+    }
+    
+private:
+    // Target cutoff follows filter gate
+    float targetCutoffFor(float filterGate) const {
+        float minCutoff = 20.0f;
+        float targetCutoff = minCutoff + filterGate * brightness * (kFullGateCutoff - minCutoff);
+        return clampf(targetCutoff, minCutoff, maxCutoff);
+    }
+    
+    // Per-sample cutoff smoothing + SVF coefficient (Standard and HQ)
+    float computeCoefficient(float filterGate) {
+        // Cutoff tracking — the vactrol model already produces a smooth,
+        // continuous decay curve. We only need minimal smoothing to prevent
+        // coefficient discontinuity at the SVF, NOT to shape the envelope.
+        // 
+        // CRITICAL: The old asymmetric smoother (0.4 open / 0.03 close)
+        // caused the filter to STAY OPEN for ~4ms after the VCA started
+        // dropping, creating a timbral plateau that the ear perceived as
+        // a double-hit: first a volume drop, then a delayed brightness drop.
+        //
+        // Fix: use fast uniform tracking. The vactrol IS the smoother.
+        smoothedCutoff += (targetCutoffFor(filterGate) - smoothedCutoff) * smoothCoef;
+        float cutoff = smoothedCutoff;
+        
+        // Bilinear prewarp, so the cutoff and resonant peak land where they
+        // are aimed all the way up. maxCutoff (0.45*sr) keeps g below ~6.3;
+        // the TPT SVF is stable for any g > 0, and the state clamp in
+        // process() still guards retrigger buildup.
+        float w = TWO_PI * cutoff / sampleRate;
+        return fmaxf(fast_tan(w * 0.5f), 0.0001f);
+    }
+    
+    // Fast tracking both directions; 48kHz values until setSampleRate()
+    float smoothCoef = kCutoffSmoothing;
+    float stateLeak = kClosedStateLeak;
+    float ecoSmoothCoef = 0.82149375f;
+    int ecoInterval = 4;
+    
+    QualityTier quality = QUALITY_STANDARD;
+    int coefCountdown = 0;
+    float heldG = 0.0001f;
+    float heldInvDen = 1.0f;
+    
+    float sampleRate = 48000.0f;
+    float maxCutoff = 20000.0f;
+    float brightness = 1.0f;
+    float resonance = 0.0f;
+    float k = 2.0f;
+    float resMakeupGain = 1.0f;
+    float bpMixAmount = 0.0f;
+    float s1 = 0.0f, s2 = 0.0f;
+    float smoothedCutoff = 20.0f;
+    float lastHP = 0.0f;
+    float lastBP = 0.0f;
+    
+    // Health counters survive reset() - they count the resets
+    uint32_t nanResets = 0;
+    uint32_t clampHits = 0;
+};
+
+// ============================================================================
+// FX PROCESSOR - Per-effect state, scaled amount curve
+// ============================================================================
+
+// Everything the FX kernels use that depends only on mode and amount (and
+// the run rate, for Grit's hold). FXProcessor rebuilds it when one of those
+// changes, so the per-sample kernels are left with the signal math alone.
+struct FXCoefficients {
+    bool bypass = true;             // Clean, or amount below 1%
+    float amount = 0.0f;            // Dry/wet mix
+    float makeup = 1.0f;
+    
+    // Tube: drive = driveBase + driveGate * gate
+    float tubeDriveBase = 1.5f;
+    float tubeDriveGate = 0.0f;
+    float tubeDCOffset = 0.0f;
+    float tubePosKnee = 0.3f;
+    float tubeNegKnee = 0.15f;
+    float tubeH2 = 0.0f;
+    bool tubeGridOn = false;
+    float tubeGridAmount = 0.0f;
+    
+    // Screamer
+    float screamerGain = 6.0f;
+    float screamerBassMix = 0.6f;
+    float screamerOutGain = 1.6f;   // Mid boost and makeup combined
+    
+    // Grit
+    float gritDrive = 2.0f;
+    float gritStraight = 1.0f;      // 1 - rectify
+    float gritRectify = 0.0f;
+    float gritFeedbackIn = 0.0f;
+    float gritBias = 0.0f;
+    bool gritCrushOn = false;
+    float gritLevels = 1024.0f;
+    float gritInvLevels = 1.0f / 1024.0f;
+    bool gritHoldOn = false;
+    float gritHoldLength = 1.0f;    // Samples between held values
+    float gritFeedbackDrive = 0.0f;
+    float gritFeedbackMix = 0.0f;
+    float gritWetMix = 0.85f;
+    float gritDryMix = 0.15f;
+};
+
+class FXProcessor {
+public:
+    // oversampling > 1 runs the processor at that multiple of sr (HQ tier).
+    // The per-sample constants are re-derived for the run rate, so they
+    // keep the same time constants (see SAMPLE RATE).
+    void setSampleRate(float sr, int oversampling = 1) {
+        float rate = sr * (float)oversampling;
+        sampleRate = rate;
+        float w = TWO_PI * 720.0f / rate;
+        screamerHPCoef = 1.0f - expf(-w);
+        screamerLPCoef = 1.0f - expf(-w);
+        float gritW = TWO_PI * 4000.0f / rate;
+        gritLPCoef = 1.0f - expf(-gritW);
+        tubeGridDecay = rateCoef(kTubeGridDecay, rate);
+        tubeDCCoef = rateCoef(kTubeDCPole, rate);
+        gritHoldScale = rate / kTunedRate;
+        updateCoefficients();
+    }
+    
+    void setMode(FXMode newMode) {
+        if (newMode == mode) return;
+        mode = newMode;
+        updateCoefficients();
+    }
+    
+    bool isActive() const { return mode != FX_CLEAN; }
+    
+    void setAmount(float amt) {
+        amt = clampf(amt, 0.0f, 1.0f);
+        if (amt == amount) return;
+        amount = amt;
+        updateCoefficients();
+    }
+    
+    float process(float input, float gate) {
+        if (coefs.bypass) return input;
+        
+        float wet;
+        switch (mode) {
+            case FX_TUBE:
+                wet = processTube(input, gate);
+                break;
+            case FX_SCREAMER:
+                wet = processScreamer(input);
+                break;
+            case FX_GRIT:
+                wet = processGrit(input);
+                break;
+            default:
+                wet = input;
+                break;
+        }
+        
+        return lerpf(input, wet * coefs.makeup, coefs.amount);
+    }
+    
+    // Sum of every recursive state, for the chunk-level finiteness check
+    float stateSum() const {
+        return tubeGridState + tubeDCPrev + tubeDCOut + screamerHP_z + screamerLP_z
+             + gritLP_z + gritHold + gritFeedback;
+    }
+    
+    void reset() {
+        tubeGridState = 0.0f;
+        tubeDCPrev = 0.0f;
+        tubeDCOut = 0.0f;
+        screamerHP_z = 0.0f;
+        screamerLP_z = 0.0f;
+        gritLP_z = 0.0f;
+        gritHold = 0.0f;
+        gritCounter = 0.0f;
+        gritFeedback = 0.0f;
+    }
+    
+private:
+    FXMode mode = FX_CLEAN;
+    float amount = 0.0f;
+    float sampleRate = 48000.0f;
+    FXCoefficients coefs;
+    
+    // Tube state
+    float tubeGridState = 0.0f;
+    float tubeDCPrev = 0.0f;
+    float tubeDCOut = 0.0f;
+    float tubeGridDecay = kTubeGridDecay;
+    float tubeDCCoef = kTubeDCPole;
+    
+    // Screamer state
+    float screamerHP_z = 0.0f;
+    float screamerLP_z = 0.0f;
+    float screamerHPCoef = 0.1f;
+    float screamerLPCoef = 0.1f;
+    
+    // Grit state
+    float gritLP_z = 0.0f;
+    float gritHold = 0.0f;
+    float gritCounter = 0.0f;
+    float gritFeedback = 0.0f;
+    float gritLPCoef = 0.5f;
+    float gritHoldScale = 1.0f;     // Hold length in samples scales with the run rate (1 at 48kHz)
+    
+    void updateCoefficients() {
+        coefs.bypass = (mode == FX_CLEAN || amount < 0.01f);
+        coefs.amount = amount;
+        
+        // Scaled amount curve: <30% subtle, 30-70% transitional, 70%+ full character
+        float amt;
+        if (amount < 0.3f) {
+            amt = amount * 0.3f;
+        } else if (amount < 0.7f) {
+            amt = 0.09f + (amount - 0.3f) * 1.0f;
+        } else {
+            amt = 0.49f + (amount - 0.7f) * 1.7f;
+        }
+        
+        switch (mode) {
+            case FX_TUBE: {
+                // 1.5 + amt * 6 * (0.5 + gate * 0.5), split around the gate
+                float driveScale = amt * 6.0f;
+                coefs.tubeDriveBase = 1.5f + driveScale * 0.5f;
+                coefs.tubeDriveGate = driveScale * 0.5f;
+                coefs.tubeDCOffset = amt * 0.18f;
+                coefs.tubePosKnee = 0.3f + amt * 0.5f;
+                coefs.tubeNegKnee = 0.15f + amt * 0.25f;
+                coefs.tubeH2 = 0.2f * amt;
+                coefs.tubeGridOn = (amt > 0.4f);
+                coefs.tubeGridAmount = 0.0005f * amt;
+                coefs.makeup = 1.4f + amt * 0.4f;
+                break;
+            }
+            case FX_SCREAMER:
+                coefs.screamerGain = 6.0f + amt * 50.0f;
+                coefs.screamerBassMix = 0.35f + (1.0f - amt) * 0.25f;
+                coefs.screamerOutGain = 1.0f + amt * 0.5f;
+                coefs.makeup = 1.6f + amt * 0.6f;
+                break;
+            case FX_GRIT: {
+                coefs.gritDrive = 2.0f + amt * 15.0f;
+                coefs.gritRectify = amt * 0.3f;
+                coefs.gritStraight = 1.0f - coefs.gritRectify;
+                coefs.gritFeedbackIn = amt * 0.4f;
+                coefs.gritBias = 0.15f * amt;
+                
+                // Bit crush from 30%: 10-bit down to 3-bit
+                coefs.gritCrushOn = (amt > 0.3f);
+                float crushAmt = coefs.gritCrushOn ? (amt - 0.3f) / 0.7f : 0.0f;
+                coefs.gritLevels = powf(2.0f, 10.0f - crushAmt * 7.0f);
+                coefs.gritInvLevels = 1.0f / coefs.gritLevels;
+                
+                // Sample rate reduction from 50%
+                coefs.gritHoldOn = (amt > 0.5f);
+                coefs.gritHoldLength = (1.0f + (amt - 0.5f) * 12.0f) * gritHoldScale;
+                
+                coefs.gritFeedbackDrive = amt * 3.0f;
+                coefs.gritFeedbackMix = 0.3f * amt;
+                coefs.gritDryMix = 0.15f * (1.0f - amt * 0.5f);
+                coefs.gritWetMix = 1.0f - coefs.gritDryMix;
+                coefs.makeup = 1.8f + amt * 0.8f;
+                break;
+            }
+            default:
+                coefs.makeup = 1.0f;
+                break;
+        }
+    }
+    
+    // TUBE - Rich 12AX7 style saturation with grid blocking
+    float processTube(float x, float gate) {
+        x *= coefs.tubeDriveBase + coefs.tubeDriveGate * gate;
+        
+        // DC offset for asymmetric harmonics (tube character)
+        x += coefs.tubeDCOffset;
+        
+        // Asymmetric soft clipping - positive clips softer (triode character)
+        float out;
+        if (x > 0.0f) {
+            out = x / (1.0f + x * coefs.tubePosKnee);
+        } else {
+            out = x / (1.0f - x * coefs.tubeNegKnee);
+        }
+        
+        // Second harmonic (even harmonics = tube warmth)
+        out += x * fabsf(x) * coefs.tubeH2;
+        
+        // Grid blocking (compression at high levels)
+        if (coefs.tubeGridOn && x > 0.5f) {
+            float excess = x - 0.5f;
+            tubeGridState -= fast_tanh(excess * 3.0f) * coefs.tubeGridAmount;
+        }
+        tubeGridState *= tubeGridDecay;
+        out += tubeGridState;
+        
+        // DC blocker
+        float dcBlocked = out - tubeDCPrev + tubeDCCoef * tubeDCOut;
+        tubeDCPrev = out;
+        tubeDCOut = dcBlocked;
+        return dcBlocked;
+    }
+    
+    // SCREAMER - Aggressive Tube Screamer overdrive with bass bypass
+    float processScreamer(float x) {
+        // Highpass - bass bypass
+        float hp = x - screamerHP_z;
+        screamerHP_z += screamerHPCoef * (x - screamerHP_z);
+        
+        // Mix back bass that bypasses the distortion
+        float gained = hp * coefs.screamerGain + x * coefs.screamerBassMix;
+        
+        // Hard clip with tanh softening
+        const float threshold = 0.5f;
+        float clipped;
+        if (gained > threshold) {
+            clipped = threshold + fast_tanh((gained - threshold) * 2.0f) * 0.4f;
+        } else if (gained < -threshold) {
+            clipped = -threshold + fast_tanh((gained + threshold) * 2.0f) * 0.4f;
+        } else {
+            clipped = gained;
+        }
+        
+        // Lowpass to smooth, then the mid boost - the Screamer signature
+        screamerLP_z += screamerLPCoef * (clipped - screamerLP_z);
+        return screamerLP_z * coefs.screamerOutGain;
+    }
+    
+    // GRIT - Fuzz + Bit Crush + Sample Rate Reduction with feedback
+    float processGrit(float x) {
+        float fuzzed = x * coefs.gritDrive;
+        
+        // Rectification for asymmetric harmonics
+        fuzzed = fuzzed * coefs.gritStraight + fabsf(fuzzed) * coefs.gritRectify;
+        
+        // Feedback for self-oscillation character, DC bias for asymmetric clipping
+        fuzzed -= gritFeedback * coefs.gritFeedbackIn;
+        fuzzed += coefs.gritBias;
+        
+        // Hard asymmetric clipping
+        if (fuzzed > 0.3f) {
+            fuzzed = 0.3f + fast_tanh((fuzzed - 0.3f) * 3.0f) * 0.4f;
+        } else if (fuzzed < -0.5f) {
+            fuzzed = -0.5f + fast_tanh((fuzzed + 0.5f) * 2.0f) * 0.3f;
+        }
+        
+        float crushed = fuzzed;
+        if (coefs.gritCrushOn) {
+            crushed = floorf(fuzzed * coefs.gritLevels + 0.5f) * coefs.gritInvLevels;
+            
+            // Sample rate reduction for lo-fi crunch
+            if (coefs.gritHoldOn) {
+                gritCounter += 1.0f;
+                if (gritCounter >= coefs.gritHoldLength) {
+                    gritCounter -= coefs.gritHoldLength;
+                    gritHold = crushed;
+                }
+                crushed = gritHold;
+            }
+        }
+        
+        // Feedback for resonant character
+        crushed -= fast_tanh(gritFeedback * coefs.gritFeedbackDrive) * coefs.gritFeedbackMix;
+        gritFeedback = crushed;
+        
+        // Light lowpass to tame aliasing
+        gritLP_z += gritLPCoef * (crushed - gritLP_z);
+        
+        // Keep some dry signal for bass integrity
+        return gritLP_z * coefs.gritWetMix + x * coefs.gritDryMix;
+    }
+};
+
+// ============================================================================
+// DC BLOCKER
+// ============================================================================
+
+class DCBlocker {
+public:
+    void setSampleRate(float sr) { pole = rateCoef(kDCBlockerPole, sr); }
+    float process(float x) {
+        float y = x - xm1 + pole * ym1;
+        xm1 = x;
+        ym1 = y;
+        return y;
+    }
+    void reset() { xm1 = ym1 = 0.0f; }
+    float stateSum() const { return xm1 + ym1; }
+private:
+    float pole = kDCBlockerPole;
+    float xm1 = 0.0f, ym1 = 0.0f;
+};
+
+// ============================================================================
+// MODAL BODY - Bank of parallel resonators after the LPG filter
+//
+// Each material gets a table of modes (frequency ratio, gain, relative
+// T60): Natural is a free wooden bar, Hard a bell/plate, Soft a felted
+// membrane. Every mode is a two-pole resonator excited by the gated
+// filter output, energy-normalised (sin w * sqrt(1 - r^2)) so a long
+// ringing mode is no louder under sustained input than a short one.
+//
+// State and coefficients are structure-of-arrays and the per-sample loop
+// has no dependency between modes, so it runs as one straight pass over
+// contiguous floats. The expensive part (cosf/expf per mode) only reruns
+// when material, decay or tuning actually moves.
+//
+// The vactrol damps the body: at kControlRateHz a closed-gate damping
+// rate, scaled by (1 - vcaGate), is added to every mode's own decay by
+// scaling the pole radius - rates add, frequencies stay put. Modes are
+// ordered so the highest (fastest-dying) are last; while the excitation
+// is silent, dead modes are trimmed off the end of the active range and
+// cost nothing until the next hit.
+// ============================================================================
+
+static constexpr int kMaxBodyModes = 32;
+static constexpr int kEcoBodyModes = 8;
+
+struct BodyModeTable {
+    int numModes;
+    float baseFreq;         // Hz at Body Tune = 0, mode ratio 1
+    float baseT60;          // Seconds, mode 1 at Decay = 50%
+    float closedT60;        // Extra damping with the vactrol fully closed
+    const float* ratio;
+    const float* gain;
+    const float* relT60;
+};
+
+// Natural - free-free wooden bar plus cross modes, highs die fast
+static const float kBodyNaturalRatio[] = {
+    1.000f, 1.572f, 2.756f, 3.420f, 4.180f, 5.404f, 6.210f, 7.440f,
+    8.933f, 10.60f, 13.34f, 16.20f
+};
+static const float kBodyNaturalGain[] = {
+    1.00f, 0.45f, 0.70f, 0.35f, 0.30f, 0.40f, 0.20f, 0.18f,
+    0.22f, 0.12f, 0.10f, 0.06f
+};
+static const float kBodyNaturalT60[] = {
+    1.00f, 0.70f, 0.55f, 0.45f, 0.40f, 0.32f, 0.28f, 0.24f,
+    0.20f, 0.16f, 0.12f, 0.10f
+};
+
+// Hard - bell partials (hum, prime, tierce, quint, nominal...) and the
+// dense inharmonic cluster above them; rings well past the gate
+static const float kBodyHardRatio[] = {
+    0.500f, 1.000f, 1.183f, 1.506f, 2.000f, 2.514f, 2.662f, 3.011f,
+    3.434f, 4.166f, 4.546f, 5.433f, 5.987f, 6.733f, 7.431f, 8.218f,
+    9.015f, 9.845f, 10.77f, 11.68f, 12.63f, 13.79f, 14.96f, 16.22f
+};
+static const float kBodyHardGain[] = {
+    0.60f, 1.00f, 0.50f, 0.80f, 0.60f, 0.50f, 0.45f, 0.40f,
+    0.40f, 0.35f, 0.30f, 0.30f, 0.25f, 0.25f, 0.20f, 0.20f,
+    0.18f, 0.16f, 0.14f, 0.12f, 0.10f, 0.09f, 0.08f, 0.07f
+};
+static const float kBodyHardT60[] = {
+    1.40f, 1.00f, 0.95f, 0.90f, 0.80f, 0.70f, 0.68f, 0.60f,
+    0.55f, 0.50f, 0.45f, 0.40f, 0.37f, 0.34f, 0.30f, 0.28f,
+    0.25f, 0.23f, 0.21f, 0.19f, 0.17f, 0.15f, 0.14f, 0.12f
+};
+
+// Soft - circular membrane (Bessel zeros), felt-damped
+static const float kBodySoftRatio[] = {
+    1.000f, 1.594f, 2.136f, 2.296f, 2.653f, 2.918f, 3.156f, 3.501f,
+    3.600f, 3.652f, 4.060f, 4.154f, 4.601f, 4.832f, 4.904f, 5.131f
+};
+static const float kBodySoftGain[] = {
+    1.00f, 0.80f, 0.60f, 0.50f, 0.45f, 0.40f, 0.35f, 0.30f,
+    0.28f, 0.25f, 0.20f, 0.18f, 0.15f, 0.13f, 0.12f, 0.10f
+};
+static const float kBodySoftT60[] = {
+    1.00f, 0.80f, 0.65f, 0.60f, 0.50f, 0.45f, 0.40f, 0.35f,
+    0.33f, 0.32f, 0.28f, 0.26f, 0.23f, 0.21f, 0.20f, 0.18f
+};
+
+// Indexed by MaterialMode
+static const BodyModeTable kBodyTables[3] = {
+    { (int)ARRAY_SIZE(kBodyNaturalRatio), 180.0f, 0.60f, 0.25f, kBodyNaturalRatio, kBodyNaturalGain, kBodyNaturalT60 },
+    { (int)ARRAY_SIZE(kBodyHardRatio),    330.0f, 2.50f, 1.20f, kBodyHardRatio,    kBodyHardGain,    kBodyHardT60 },
+    { (int)ARRAY_SIZE(kBodySoftRatio),    110.0f, 0.35f, 0.08f, kBodySoftRatio,    kBodySoftGain,    kBodySoftT60 },
+};
+
+class ModalBody {
+public:
+    void setSampleRate(float sr) {
+        controlFrames = controlInterval(kControlRateHz, sr);
+        if (sr == sampleRate) return;
+        sampleRate = sr;
+        coefDirty = true;
+    }
+    
+    // Cheap to call every CV update: only a real change rebuilds the modes
+    void configure(MaterialMode material, float decayParam, float tuneSemitones) {
+        if (material != this->material) coefDirty = true;
+        if (fabsf(decayParam - this->decayParam) > kDecayTolerance) coefDirty = true;
+        if (tuneSemitones != this->tune) coefDirty = true;
+        if (!coefDirty) return;
+        
+        this->material = material;
+        this->decayParam = decayParam;
+        this->tune = tuneSemitones;
+        rebuildModes();
+    }
+    
+    void setQuality(QualityTier tier) {
+        modeCap = (tier == QUALITY_ECO) ? kEcoBodyModes : kMaxBodyModes;
+        if (activeCount > modeCap) activeCount = modeCap;
+    }
+    
+    float process(float x, float vcaGate) {
+        if (--controlCountdown <= 0) {
+            controlCountdown = controlFrames;
+            updateControl(vcaGate);
+        }
+        float level = fabsf(x);
+        excitationPeak = fmaxf(excitationPeak, level);
+        
+        // Any audible excitation brings every mode back
+        if (level >= kCullLevel) activeCount = (modeCount < modeCap) ? modeCount : modeCap;
+        
+        float out = 0.0f;
+        const int n = activeCount;
+        for (int m = 0; m < n; m++) {
+            float y = b[m] * x + a1[m] * y1[m] - a2[m] * y2[m];
+            y2[m] = y1[m];
+            y1[m] = y;
+            out += y;
+        }
+        return out * kBodyLevel;
+    }
+    
+    int getActiveModes() const { return activeCount; }
+    
+    float stateSum() const {
+        float sum = 0.0f;
+        for (int m = 0; m < kMaxBodyModes; m++) sum += y1[m] + y2[m];
+        return sum;
+    }
+    
+    void reset() {
+        memset(y1, 0, sizeof(y1));
+        memset(y2, 0, sizeof(y2));
+        activeCount = 0;
+        excitationPeak = 0.0f;
+        controlCountdown = 0;
+    }
+    
+private:
+    static constexpr float kDecayTolerance = 1.0f / 128.0f;
+    static constexpr float kCullLevel = 1.0e-5f;   // ~-100dB re 1.0 - well under the DAC floor
+    static constexpr float kBodyLevel = 0.35f;     // Sum of a struck table ~ the dry pluck
+    
+    void rebuildModes() {
+        coefDirty = false;
+        const BodyModeTable& t = kBodyTables[material];
+        float fundamental = t.baseFreq * exp2f(tune * (1.0f / 12.0f));
+        // Decay 0-100% spans 0.25x-2x of the material's natural ring
+        float t60Scale = 0.25f + 1.75f * decayParam;
+        float nyquistGuard = 0.45f * sampleRate;
+        // A resonator's gain to a sustained input grows with sqrt(sr) for
+        // a fixed T60; hold it at its 48kHz level
+        float rateGain = sqrtf(kTunedRate / sampleRate);
+        
+        modeCount = 0;
+        for (int m = 0; m < t.numModes; m++) {
+            float freq = fundamental * t.ratio[m];
+            if (freq >= nyquistGuard) break;    // Ratios ascend, so the rest are above too
+            float w = TWO_PI * freq / sampleRate;
+            float r = expf(-6.9078f / (t.baseT60 * t60Scale * t.relT60[m] * sampleRate));
+            a1Base[m] = 2.0f * r * cosf(w);
+            a2Base[m] = r * r;
+            b[m] = t.gain[m] * sinf(w) * sqrtf(1.0f - r * r) * rateGain;
+            a1[m] = a1Base[m];
+            a2[m] = a2Base[m];
+            modeCount = m + 1;
+        }
+        
+        // Modes beyond the new table fall silent
+        for (int m = modeCount; m < kMaxBodyModes; m++) {
+            y1[m] = y2[m] = 0.0f;
+        }
+        if (activeCount > modeCount) activeCount = modeCount;
+        closedDampingRate = 6.9078f / (t.closedT60 * sampleRate);
+        controlCountdown = 0;
+    }
+    
+    void updateControl(float vcaGate) {
+        // Closing vactrol adds its damping rate to every mode (culled ones
+        // too, so they come back with current coefficients)
+        float g = expf(-closedDampingRate * (1.0f - clampf(vcaGate, 0.0f, 1.0f)));
+        float g2 = g * g;
+        const int n = modeCount;
+        for (int m = 0; m < n; m++) {
+            a1[m] = a1Base[m] * g;
+            a2[m] = a2Base[m] * g2;
+        }
+        
+        // Trim dead modes off the top while nothing is exciting the body
+        if (excitationPeak < kCullLevel) {
+            while (activeCount > 0 &&
+                   fabsf(y1[activeCount - 1]) + fabsf(y2[activeCount - 1]) < kCullLevel) {
+                --activeCount;
+                y1[activeCount] = y2[activeCount] = 0.0f;
+            }
+        }
+        excitationPeak = 0.0f;
+    }
+    
+    float a1[kMaxBodyModes] = {};
+    float a2[kMaxBodyModes] = {};
+    float b[kMaxBodyModes] = {};
+    float y1[kMaxBodyModes] = {};
+    float y2[kMaxBodyModes] = {};
+    float a1Base[kMaxBodyModes] = {};
+    float a2Base[kMaxBodyModes] = {};
+    
+    float sampleRate = 48000.0f;
+    MaterialMode material = MATERIAL_NATURAL;
+    float decayParam = 0.5f;
+    float tune = 0.0f;
+    bool coefDirty = true;
+    int modeCount = 0;
+    int modeCap = kMaxBodyModes;
+    int activeCount = 0;
+    int controlFrames = 32;
+    int controlCountdown = 0;
+    float excitationPeak = 0.0f;
+    float closedDampingRate = 0.0f;
+};
+
+// ============================================================================
+// TRIGGER DETECTOR - Schmitt trigger with hysteresis + rearm guard
+//
+// CRITICAL FIX (v7.2.0): The old detector used a single threshold with
+// only 5ms lockout. Noisy Eurorack triggers would fire twice:
+//   1. Rising edge crosses threshold → trigger #1, lockout starts
+//   2. Signal wobbles below threshold during pulse
+//   3. After 5ms lockout: signal still high, or noise re-crosses → trigger #2
+//
+// Fix: Schmitt trigger (separate high/low thresholds) + must see N
+// consecutive low samples before re-arming + 15ms lockout.
+// ============================================================================
+
+class TriggerDetector {
+public:
+    void setSampleRate(float sr) {
+        rearmLength = samplesFor(kTriggerRearmTime, sr);
+        lockoutLength = samplesFor(kTriggerLockoutTime, sr);
+    }
+    void setThreshold(float v) { 
+        thresholdHigh = clampf(v, 0.01f, 5.0f);
+        // Hysteresis: must drop to 70% of threshold before re-arming
+        thresholdLow = thresholdHigh * 0.7f;
+    }
+    
+    bool process(float input) {
+        if (lockoutSamples > 0) {
+            lockoutSamples--;
+        }
+        
+        // Schmitt trigger logic:
+        // - To fire: input must cross thresholdHigh while armed
+        // - To re-arm: input must drop below thresholdLow for rearmLength samples
+        bool aboveHigh = input > thresholdHigh;
+        bool belowLow = input < thresholdLow;
+        
+        // Track consecutive samples below low threshold for re-arm
+        if (belowLow) {
+            lowCount++;
+        } else {
+            lowCount = 0;
+        }
+        
+        // Re-arm only after signal has been convincingly low
+        if (!armed && lowCount >= rearmLength) {
+            armed = true;
+        }
+        
+        // Fire on rising edge above high threshold, if armed and not locked out
+        bool trig = aboveHigh && armed && (lockoutSamples == 0);
+        
+#if HM_HEALTH
+        // Count edges (not held-high samples) that were refused
+        if (aboveHigh && !wasAboveHigh && !trig) {
+            if (lockoutSamples > 0) lockoutRejects++;
+            else disarmedRejects++;
+        }
+        wasAboveHigh = aboveHigh;
+#endif
+        
+        if (trig) {
+            lastLevel = input;
+            // Sub-sample onset: linear interpolation between this sample and
+            // the previous one gives how long ago (0-1 samples) the edge
+            // actually crossed thresholdHigh. Only meaningful when this is
+            // the crossing sample - a fire at the end of the lockout with the
+            // input already high has no edge to locate.
+            float rise = input - prevInput;
+            lastOffset = (prevInput <= thresholdHigh && rise > 0.0f)
+                       ? (input - thresholdHigh) / rise : 0.0f;
+            armed = false;  // Must re-arm before next trigger
+            lowCount = 0;
+            lockoutSamples = lockoutLength;
+        }
+        
+        prevInput = input;
+        return trig;
+    }
+    
+    float getLastLevel() const { return lastLevel; }
+    // Samples between the interpolated threshold crossing and the firing sample
+    float getLastOffset() const { return lastOffset; }
+    void reset() { 
+        armed = true; 
+        lastLevel = 0.0f; 
+        lastOffset = 0.0f;
+        prevInput = 0.0f;
+        lockoutSamples = 0; 
+        lowCount = 0; 
+        wasAboveHigh = false;
+    }
+    
+    void addHealth(HealthCounters& h) const {
+        h.count[HEALTH_TRIG_LOCKOUT] += lockoutRejects;
+        h.count[HEALTH_TRIG_DISARMED] += disarmedRejects;
+    }
+private:
+    int rearmLength = 16;           // ~0.33ms: must be low this long to re-arm
+    int lockoutLength = 720;        // 15ms
+    float thresholdHigh = 0.1f;
+    float thresholdLow = 0.07f;
+    bool armed = true;
+    float lastLevel = 0.0f;
+    float lastOffset = 0.0f;
+    float prevInput = 0.0f;
+    int lockoutSamples = 0;
+    int lowCount = 0;
+    bool wasAboveHigh = false;
+    uint32_t lockoutRejects = 0;
+    uint32_t disarmedRejects = 0;
+};
+
+// ============================================================================
+// ONSET DETECTOR - Self-triggering from the Left Input audio
+//
+// An instant-attack peak follower (5ms release) is compared against two
+// references: a 30ms average of the rectified signal, and a mask set to the
+// peak of the last detected hit that decays over 100ms. The detection
+// function, fast - max(2 * slow, 1.5 * mask), only goes positive when the
+// level jumps well above what the recent past makes normal - a steady tone
+// peaks at ~1.6x its average, and a hit's own ringing tail stays under its
+// mask until the average has caught up with it. Quieter hits landing on a
+// louder tail are masked, much as they are to the ear.
+//
+// The result feeds TriggerDetector, which supplies the threshold,
+// hysteresis, re-arm guard and lockout. For 5ms after a detection the mask
+// keeps climbing with the transient so step() can raise the velocity to
+// the hit's true peak - detection happens on the leading edge.
+// ============================================================================
+
+enum TriggerSource {
+    TRIG_SOURCE_BUS = 0,
+    TRIG_SOURCE_AUDIO = 1,
+    TRIG_SOURCE_CV = 2      // Trigger bus drives the vactrol continuously (LPGChannel::setCVMode)
+};
+
+class OnsetDetector {
+public:
+    void setSampleRate(float sr) {
+        fastRelease = expf(-1.0f / (0.005f * sr));
+        slowCoef = 1.0f - expf(-1.0f / (0.030f * sr));
+        maskRelease = expf(-1.0f / (0.100f * sr));
+        peakWindow = (int)(0.005f * sr);
+    }
+    
+    // Onset detection function for one input sample, in volts
+    float process(float x) {
+        float rect = fabsf(x);
+        fast = fmaxf(rect, fast * fastRelease);
+        slow += (rect - slow) * slowCoef;
+        mask *= maskRelease;
+        if (peakCountdown > 0) {
+            --peakCountdown;
+            mask = fmaxf(mask, fast);
+        }
+        return fast - fmaxf(kAverageRatio * slow, kMaskRatio * mask);
+    }
+    
+    // Call when the detection function fired: masks the hit's own tail and
+    // opens the peak window
+    void onFired() {
+        mask = fast;
+        peakCountdown = peakWindow;
+    }
+    
+    // Still inside the peak window of the last detection
+    bool isTrackingPeak() const { return peakCountdown > 0; }
+    
+    // Peak level of the transient so far, for velocity
+    float getEnergy() const { return fast; }
+    void reset() { fast = slow = mask = 0.0f; peakCountdown = 0; }
+    
+private:
+    static constexpr float kAverageRatio = 2.0f;
+    static constexpr float kMaskRatio = 1.5f;
+    float fastRelease = 0.9958f;
+    float slowCoef = 0.0007f;
+    float maskRelease = 0.9998f;
+    int peakWindow = 240;
+    float fast = 0.0f;
+    float slow = 0.0f;
+    float mask = 0.0f;
+    int peakCountdown = 0;
+};
+
+// ============================================================================
+// STRIKE DETECTOR - Trigger bus or audio onsets -> strikes with velocity
+//
+// Bus: Schmitt trigger on the trigger voltage, velocity from its level.
+// Audio: OnsetDetector into the same Schmitt/lockout logic; while the
+// attack is still climbing, STRIKE_RAISE reports the higher velocity so
+// the channel can follow it up (LPGChannel::raiseVelocity()).
+// ============================================================================
+
+enum StrikeEvent {
+    STRIKE_NONE = 0,
+    STRIKE_FIRE,        // New hit - LPGChannel::trigger(velocity, getOffset())
+    STRIKE_RAISE        // Same hit, louder than first measured
+};
+
+class StrikeDetector {
+public:
+    void setSampleRate(float sr) {
+        trigger.setSampleRate(sr);
+        onset.setSampleRate(sr);
+    }
+    void setThreshold(float v) { trigger.setThreshold(v); }
+    void setSource(TriggerSource s) { source = s; }
+    TriggerSource getSource() const { return source; }
+    
+    // One sample of the trigger bus (Bus) or of the audio input (Audio)
+    StrikeEvent process(float x, float& velocity) {
+        if (source == TRIG_SOURCE_AUDIO) {
+            bool tracking = onset.isTrackingPeak();
+            bool fired = trigger.process(onset.process(x));
+            // Velocity from the transient's level, 5V = full. No floor -
+            // the threshold already rejects the quiet stuff.
+            float level = clampf(onset.getEnergy() / 5.0f, 0.0f, 1.0f);
+            if (fired) {
+                onset.onFired();
+                velocity = lastVelocity = level;
+                return STRIKE_FIRE;
+            }
+            // Still on the attack: follow it up to the true peak
+            if (tracking && level > lastVelocity) {
+                velocity = lastVelocity = level;
+                return STRIKE_RAISE;
+            }
+            return STRIKE_NONE;
+        }
+        
+        if (!trigger.process(x)) return STRIKE_NONE;
+        // Velocity: scale trigger level to 0.35-1.0 range
+        // Floor at 0.35 prevents natural trigger voltage wobble from
+        // creating wildly different hit intensities. Low enough for
+        // false triggers to be quiet, high enough for consistency.
+        velocity = lastVelocity = clampf(trigger.getLastLevel() / 5.0f, 0.35f, 1.0f);
+        return STRIKE_FIRE;
+    }
+    
+    // Sub-sample onset of the last STRIKE_FIRE
+    float getOffset() const { return trigger.getLastOffset(); }
+    
+    void reset() {
+        trigger.reset();
+        onset.reset();
+        lastVelocity = 0.0f;
+    }
+    
+    void addHealth(HealthCounters& h) const { trigger.addHealth(h); }
+    
+private:
+    TriggerDetector trigger;
+    OnsetDetector onset;
+    TriggerSource source = TRIG_SOURCE_BUS;
+    float lastVelocity = 0.0f;
+};
+
+// ============================================================================
+// HIT CACHE - Replays the envelope of repeated identical strikes
+//
+// A strike's envelope is a pure function of the vactrol state it starts
+// from and the decay settings, so a sequencer firing the same hit again and
+// again computes the same expf/powf curve every time. The cache keeps the
+// first slotFrames samples of each curve (vactrol state + filter gate) in
+// caller memory, fills lazily while a hit plays live, and replays them
+// bit-exactly for later hits with the same key. Past the end of a slot the
+// channel carries on live from the exact recorded state.
+//
+// Keys hold the exact values, so a strike that differs in the last bit of
+// its velocity or onset plays live: the cache never changes what a hit
+// sounds like. Sequencer gates and MIDI notes repeat exactly.
+//
+// Hit memory and CV mode make every curve unique, and Eco already runs the
+// envelope at control rate, so those never use it. A decay change while a
+// curve plays (Decay CV) drops back to live computation.
+// ============================================================================
+
+static constexpr int kHitCacheSlots = 8;
+
+struct HitCacheKey {
+    float startState;       // Vactrol state just after the trigger
+    float velocity;
+    float logDecayCoef;
+    float decayMod;
+    float filterExponent;
+    
+    bool operator==(const HitCacheKey& o) const {
+        return startState == o.startState && velocity == o.velocity && logDecayCoef == o.logDecayCoef &&
+               decayMod == o.decayMod && filterExponent == o.filterExponent;
+    }
+};
+
+struct HitCacheFrame {
+    float state;            // Vactrol state after this sample's decay step
+    float filterGate;       // vcaGate is sqrtf(state), one instruction
+};
+
+class HitCache {
+public:
+    // Carves `bytes` of caller memory (DRAM on the module) into the slots
+    void init(void* memory, uint32_t bytes) {
+        slotFrames = (int)(bytes / (sizeof(HitCacheFrame) * kHitCacheSlots));
+        for (int i = 0; i < kHitCacheSlots; i++) {
+            slots[i].frames = (HitCacheFrame*)memory + i * slotFrames;
+        }
+        clear();
+    }
+    
+    void clear() {
+        for (int i = 0; i < kHitCacheSlots; i++) {
+            slots[i].length = 0;
+            slots[i].lastUse = 0;
+            slots[i].generation++;
+        }
+        hits = misses = 0;
+    }
+    
+    // The slot holding this key's curve, or the least recently used one,
+    // emptied to record it. -1 if the cache has no memory.
+    int acquire(const HitCacheKey& key, uint32_t& generation) {
+        if (slotFrames <= 0) return -1;
+        int lru = 0;
+        for (int i = 0; i < kHitCacheSlots; i++) {
+            if (slots[i].lastUse > 0 && slots[i].key == key) {
+                slots[i].lastUse = ++useClock;
+                generation = slots[i].generation;
+                hits++;
+                return i;
+            }
+            if (slots[i].lastUse < slots[lru].lastUse) lru = i;
+        }
+        Slot& slot = slots[lru];
+        slot.key = key;
+        slot.length = 0;
+        slot.lastUse = ++useClock;
+        generation = ++slot.generation;
+        misses++;
+        return lru;
+    }
+    
+    // Frame `pos` if it has been recorded and the slot still holds the curve
+    bool read(int slot, uint32_t generation, int pos, HitCacheFrame& frame) const {
+        const Slot& s = slots[slot];
+        if (s.generation != generation || pos >= s.length) return false;
+        frame = s.frames[pos];
+        return true;
+    }
+    
+    // Records frame `pos`, computed live. False once the curve can't be
+    // followed any further: slot full, or reused for another key.
+    bool append(int slot, uint32_t generation, int pos, const HitCacheFrame& frame) {
+        Slot& s = slots[slot];
+        if (s.generation != generation || pos > s.length || pos >= slotFrames) return false;
+        if (pos == s.length) {
+            s.frames[pos] = frame;
+            s.length++;
+        }
+        return true;
+    }
+    
+    int getSlotFrames() const { return slotFrames; }
+    uint32_t getHits() const { return hits; }
+    uint32_t getMisses() const { return misses; }
+    
+private:
+    struct Slot {
+        HitCacheKey key = {};
+        HitCacheFrame* frames = nullptr;
+        int length = 0;                 // Frames recorded so far
+        uint32_t lastUse = 0;
+        uint32_t generation = 0;        // Bumped on reuse, so followers notice
+    };
+    
+    Slot slots[kHitCacheSlots];
+    int slotFrames = 0;
+    uint32_t useClock = 0;
+    uint32_t hits = 0;
+    uint32_t misses = 0;
+};
+
+// ============================================================================
+// LPG CHANNEL - Single vactrol model with level-dependent decay
+//
+// Based on Parker & D'Angelo, DAFX-13:
+// One continuous curve from the vactrol's photoresistive element.
+// Filter and VCA derive from nonlinear transfer functions of
+// the single vactrol state, not separate envelopes.
+// ============================================================================
+
+class LPGChannel {
+public:
+    void setSampleRate(float sr) {
+        sampleRate = sr;
+        filter.setSampleRate(sr);
+        fx.setSampleRate(sr, quality == QUALITY_HQ ? 2 : 1);
+        body.setSampleRate(sr);
+        dcBlocker.setSampleRate(sr);
+        triggerVisualDecay = rateCoef(kTriggerVisualDecay, sr);
+        ecoInterval = controlInterval(kEcoRateHz, sr);
+        cvInterval = controlInterval(kCVEnvelopeRateHz, sr);
+        
+        // Attack per CV interval: the photocell closes in on the LED level
+        // with the material's time constant
+        for (int m = 0; m < 3; m++) {
+            cvAttackCoef[m] = expf(-(float)cvInterval / (kMaterialAttackTime[m] * sr));
+        }
+    }
+    
+    void setQuality(QualityTier tier) {
+        if (tier == quality) return;
+        bool oversample = (tier == QUALITY_HQ);
+        bool oversampleChanged = oversample != (quality == QUALITY_HQ);
+        quality = tier;
+        filter.setQuality(tier);
+        body.setQuality(tier);
+        
+        // Eco picks the envelope up from wherever it is on the next sample
+        rampCountdown = 0;
+        rampSnap = true;
+        hitSlot = -1;
+        
+        if (oversampleChanged) {
+            // FX state at the old rate is meaningless at the new one
+            fx.setSampleRate(sampleRate, oversample ? 2 : 1);
+            fx.reset();
+            oversampler.reset();
+            resetTapDelay();
+        }
+    }
+    
+    void setParams(float resonance, float decayParam, float openParam, float dampening,
+                   MaterialMode material, FXMode fxMode, float fxAmount, float inputGain,
+                   bool hitMemory) {
+        this->baseOpenCeiling = openParam;
+        this->openCeiling = openParam;
+        this->dampening = dampening;
+        this->material = material;
+        this->inputGain = inputGain;
+        this->hitMemoryOn = hitMemory;
+        this->baseDecayParam = decayParam;
+        
+        updateDecayFromParam(decayParam);
+        
+        // Dampening = hand on drum / towel on cymbal
+        // Reduces brightness MORE aggressively (mutes upper harmonics)
+        // Also slightly reduces resonance (dampened objects don't ring)
+        float dampeningBrightness = 1.0f - dampening * 0.85f;  // At 100%: 15% brightness
+        float dampeningResCut = 1.0f - dampening * 0.4f;       // At 100%: 60% resonance
+        
+        filter.setResonance(resonance * dampeningResCut);
+        filter.setBrightness(kMaterialBrightness[material] * dampeningBrightness);
+        
+        // HQ only oversamples while FX is on: switching it on restarts the
+        // oversampler and the tap delay from silence, not from whatever
+        // they held when FX was last on
+        bool fxWasActive = fx.isActive();
+        fx.setMode(fxMode);
+        fx.setAmount(fxAmount);
+        if (fx.isActive() && !fxWasActive) {
+            oversampler.reset();
+            resetTapDelay();
+        }
+        
+        if (bodyOn) body.configure(material, decayParam, bodyTune);
+    }
+    
+    // Modal body: tuning in semitones, mix 0-1 (dry filter -> body)
+    void setBody(bool on, float tuneSemitones, float mix) {
+        if (on && !bodyOn) body.reset();
+        bodyOn = on;
+        bodyTune = tuneSemitones;
+        bodyMix = mix;
+        if (on) body.configure(material, baseDecayParam, tuneSemitones);
+    }
+    
+    // Fast CV update - only updates targets, no expensive calculations
+    void updateCV(float decayMod, float openMod) {
+        openCeiling = clampf(baseOpenCeiling + openMod, 0.0f, 1.0f);
+        float modDecay = clampf(baseDecayParam + decayMod, 0.0f, 1.0f);
+        updateDecayFromParam(modDecay);
+    }
+    
+    // Shared by every channel that has it on; nullptr computes every hit live
+    void setHitCache(HitCache* cache) {
+        hitCache = cache;
+        hitSlot = -1;
+    }
+    
+    // offset: how far (0-1 samples) before the current sample the trigger
+    // edge really happened, from TriggerDetector::getLastOffset()
+    void trigger(float velocity = 1.0f, float offset = 0.0f) {
+        float targetLevel = velocity * openCeiling;
+        
+        if (hitMemoryOn) {
+            float previousState = vactrolState;
+            targetLevel = clampf(vactrolState + targetLevel, 0.0f, 1.2f);
+            
+            // Warm vactrol effect: accumulated energy means the vactrol
+            // stays open longer. Scale decay slowdown by how much state
+            // we're building on. At full accumulation, decay slows ~40%.
+            float warmth = clampf(previousState * 0.4f, 0.0f, 0.4f);
+            memoryDecayScale = 1.0f + warmth;  // 1.0 = no effect, 1.4 = 40% slower
+        } else {
+            memoryDecayScale = 1.0f;
+        }
+        
+        // SINGLE VACTROL MODEL — The vactrol IS the envelope.
+        //
+        // In the real Buchla 292, CV hits the LED, which instantly illuminates
+        // the photoresistor. The "click" is the gate snapping open.
+        // There is NO separate filter envelope and VCA envelope.
+        // One resistance (Rf) controls everything.
+        //
+        // The vactrol state then decays via level-dependent continuous curve
+        // (modeled in process()). The "filter closes before VCA" behavior
+        // comes from nonlinear transfer functions, not separate envelopes.
+        vactrolState = targetLevel;
+        
+        // Sub-sample onset: the LED lit `offset` samples ago, so start with
+        // that much decay already applied - same law as process(), one expf
+        // per event. Keeps layered instances phase-coherent to well under
+        // a sample even when their trigger edges are sampled differently.
+        if (offset > 0.0f) {
+            float speedFactor = 1.0f + targetLevel * targetLevel * vactrolDecayMod;
+            float velShape = 1.0f + (velocity - 0.5f) * 0.3f * targetLevel;
+            vactrolState *= expf(offset * speedFactor * velShape / memoryDecayScale * logBaseDecayCoef);
+        }
+        
+        triggerVelocity = velocity;
+        triggerVisual = 1.0f;
+        
+        // Eco / CV mode: jump the gates to the new state instead of ramping up to it
+        rampCountdown = 0;
+        rampSnap = true;
+        
+        // Dampen filter state on retrigger to prevent energy accumulation
+        filter.dampStateOnRetrigger();
+        
+        hitSlot = -1;
+        if (hitCache && !hitMemoryOn && !cvMode && quality != QUALITY_ECO && vactrolState > 0.0f) {
+            hitKey.startState = vactrolState;
+            hitKey.velocity = velocity;
+            hitKey.logDecayCoef = logBaseDecayCoef;
+            hitKey.decayMod = vactrolDecayMod;
+            hitKey.filterExponent = filterExponent;
+            hitSlot = hitCache->acquire(hitKey, hitGeneration);
+            hitPos = 0;
+        }
+    }
+    
+    // CV mode: the vactrol follows setLED() continuously, like a 292 driven
+    // from an envelope, instead of decaying from strikes. Triggers still
+    // work on top of it.
+    void setCVMode(bool on) {
+        if (on == cvMode) return;
+        cvMode = on;
+        ledLevel = 0.0f;
+        rampCountdown = 0;
+        rampSnap = true;
+        hitSlot = -1;
+    }
+    
+    // LED drive for CV mode, 0-1 (0-5V), scaled by Open. Read once per
+    // cvInterval samples, so it is safe to set every sample.
+    void setLED(float level) { ledLevel = level; }
+    
+    // A trigger's velocity turned out low - the detector fired on the leading
+    // edge of a slower attack. Lift the vactrol by the difference, so the
+    // gate follows the attack up instead of retriggering.
+    void raiseVelocity(float velocity) {
+        if (velocity <= triggerVelocity) return;
+        vactrolState = clampf(vactrolState + (velocity - triggerVelocity) * openCeiling, 0.0f, 1.2f);
+        triggerVelocity = velocity;
+        hitSlot = -1;
+    }
+    
+    float process(float input) {
+        float filterGate, vcaGate;
+        if (cvMode) {
+            advanceEnvelopeCV(filterGate, vcaGate);
+        } else if (quality == QUALITY_ECO) {
+            advanceEnvelopeEco(filterGate, vcaGate);
+        } else {
+            advanceEnvelope(filterGate, vcaGate);
+        }
+        
+        // Dampening: reduce VCA ceiling (hand absorbs energy, doesn't speed it up)
+        // At 100% dampening: output is 25% of normal — heavily muted but same decay shape
+        float dampeningVCA = 1.0f - dampening * 0.75f;
+        vcaGate *= dampeningVCA;
+        
+        // At very low levels, ensure clean zero-crossing
+        vcaGate = (vcaGate < 0.001f) ? 0.0f : vcaGate;
+        filterGate = (filterGate < 0.001f) ? 0.0f : filterGate;
+        
+        lastGate = vcaGate;
+        lastFilterGate = filterGate;
+        HM_PROF(if (profiler) profiler->lap(PROF_ENVELOPE));
+        
+        input *= inputGain;
+        
+        float filtered = filter.process(input, filterGate, vcaGate);
+        HM_PROF(if (profiler) profiler->lap(PROF_FILTER));
+        
+        if (bodyOn) {
+            float resonant = body.process(filtered, vcaGate);
+            filtered += bodyMix * (resonant - filtered);
+            HM_PROF(if (profiler) profiler->lap(PROF_BODY));
+        }
+        
+        float processed;
+        if (quality == QUALITY_HQ && fx.isActive()) {
+            // HQ: the nonlinear stages run at 2x so their harmonics above
+            // Nyquist are filtered off instead of folding back
+            float even, odd;
+            oversampler.upsample(filtered, even, odd);
+            even = fx.process(even, vcaGate);
+            odd = fx.process(odd, vcaGate);
+            processed = oversampler.downsample(even, odd);
+            
+            // Hold the output taps back by the same latency
+            OutputTaps now = { filter.getHighpass() * vcaGate, filter.getBandpass() * vcaGate, filterGate, vcaGate };
+            delayedTaps = tapDelay[tapPos];
+            tapDelay[tapPos] = now;
+            tapPos = (tapPos + 1) & (kOversampleLatency - 1);
+            tapsDelayed = true;
+        } else {
+            tapsDelayed = false;
+            processed = fx.process(filtered, vcaGate);
+        }
+        
+        processed = dcBlocker.process(processed);
+        
+        // Final safety limiter - bounds every finite value to +-1, so only
+        // NaN can get past it (caught by recoverChunk())
+        processed = soft_saturate(processed, 0.98f);
+        
+        triggerVisual *= triggerVisualDecay;
+        HM_PROF(if (profiler) profiler->lap(PROF_FX));
+        
+        return processed;
+    }
+    
+    float getGateValue() const { return lastGate; }
+    float getFilterGate() const { return lastFilterGate; }
+    float getTriggerVisual() const { return triggerVisual; }
+    
+    // Taps for the extra outputs, lined up with what process() returned:
+    // the SVF's other responses from the same pass through the VCA (no
+    // extra filtering, pre-body, pre-FX) and the two gates. HQ with FX
+    // active returns kOversampleLatency samples late, so the taps are
+    // delayed to match.
+    float getGatedHighpass() const { return tapsDelayed ? delayedTaps.highpass : filter.getHighpass() * lastGate; }
+    float getGatedBandpass() const { return tapsDelayed ? delayedTaps.bandpass : filter.getBandpass() * lastGate; }
+    float getOutputFilterGate() const { return tapsDelayed ? delayedTaps.filterGate : lastFilterGate; }
+    float getOutputGate() const { return tapsDelayed ? delayedTaps.vcaGate : lastGate; }
+    
+    // NaN/inf protection - last line of defense against lockup. Runs once
+    // per chunk after process(): if any state went non-finite, the chunk's
+    // output is zeroed and the signal path restarts from silence.
+    bool recoverChunk(float* out, int numFrames) {
+        bool filterReset = filter.recoverIfInvalid();
+        float probe = fx.stateSum() + dcBlocker.stateSum() + vactrolState;
+        if (bodyOn) probe += body.stateSum();
+        if (!filterReset && isFiniteF(probe)) return false;
+        
+        memset(out, 0, sizeof(float) * numFrames);
+        filter.reset();
+        fx.reset();
+        body.reset();
+        oversampler.reset();
+        resetTapDelay();
+        dcBlocker.reset();
+        if (!isFiniteF(vactrolState)) vactrolState = 0.0f;
+        hitSlot = -1;
+        HM_HEALTH_COUNT(outputResets++);
+        return true;
+    }
+    
+    void addHealth(HealthCounters& h) const {
+        filter.addHealth(h);
+        h.count[HEALTH_OUTPUT_RESET] += outputResets;
+    }
+    
+#if HM_TRACE
+    void fillTrace(TraceFrame& f, float output) const {
+        f.v[TRACE_VACTROL] = vactrolState;
+        f.v[TRACE_FILTER_GATE] = lastFilterGate;
+        f.v[TRACE_VCA_GATE] = lastGate;
+        f.v[TRACE_MEMORY_SCALE] = memoryDecayScale;
+        f.v[TRACE_OUTPUT] = output;
+        filter.fillTrace(f);
+    }
+#endif
+    
+#if HM_PROFILE
+    void setProfiler(StageProfiler* p) { profiler = p; }
+#endif
+    
+    void reset() {
+        filter.reset();
+        fx.reset();
+        body.reset();
+        oversampler.reset();
+        resetTapDelay();
+        dcBlocker.reset();
+        vactrolState = 0.0f;
+        rampCountdown = 0;
+        rampSnap = true;
+        hitSlot = -1;
+        triggerVisual = 0.0f;
+        lastGate = 0.0f;
+        lastFilterGate = 0.0f;
+    }
+    
+private:
+    void resetTapDelay() {
+        memset(tapDelay, 0, sizeof(tapDelay));
+        delayedTaps = OutputTaps();
+        tapPos = 0;
+    }
+    
+    // Vactrol decay + transfer curves, one sample (Standard and HQ)
+    void advanceEnvelope(float& filterGate, float& vcaGate) {
+        // =====================================================
+        // SINGLE VACTROL ENVELOPE — LEVEL-DEPENDENT DECAY
+        // =====================================================
+        //
+        // Based on Parker & D'Angelo, DAFX-13:
+        // The vactrol's photoresistive element has a continuous decay
+        // where higher illumination (higher state) decays faster due to
+        // greater carrier recombination rate. This naturally produces
+        // the "thwack → body" contour that the old two-stage approach
+        // tried to achieve with a hard boundary and crossfade.
+        //
+        // The key: ONE continuous curve, NO stage boundaries.
+        //   High level → fast decay (the initial transient/thwack)
+        //   Low level → slow decay (the lingering body/tail)
+        //
+        // vactrolDecayMod controls the strength of this effect:
+        //   0 = pure exponential (electronic, uniform decay)
+        //   2+ = strong level-dependence (struck/plucked character)
+        
+        // Hit cache: replay this sample if an identical hit recorded it
+        HitCacheFrame cached;
+        if (hitSlot >= 0 && hitCache->read(hitSlot, hitGeneration, hitPos, cached)) {
+            hitPos++;
+            vactrolState = cached.state;
+            filterGate = cached.filterGate;
+            vcaGate = sqrtf(fmaxf(vactrolState, 0.0f));
+            if (vactrolState == 0.0f) hitSlot = -1;
+            return;
+        }
+        
+        if (vactrolState > 0.0f) {
+            // Level-dependent speed: faster at high levels, slower at low
+            // The squared term gives us a continuous curve that gracefully transitions
+            // from "thwack" speed to "body" speed — no stages, no crossfade
+            float speedFactor = 1.0f + vactrolState * vactrolState * vactrolDecayMod;
+            
+            // Velocity shapes the initial speed — harder hits decay faster initially
+            // (more energy in = faster initial dissipation, like a real struck object)
+            float velShape = 1.0f + (triggerVelocity - 0.5f) * 0.3f * vactrolState;
+            
+            // OPTIMIZATION: Combine both power operations into single expf
+            // powf(coef, speed) = expf(speed * logf(coef))
+            // powf(result, velShape) = expf(velShape * speed * logf(coef))
+            // Combined: expf(speedFactor * velShape * logBaseDecayCoef)
+            // This replaces 2x powf (~200 cycles each) with 1x expf (~60 cycles)
+            float totalPower = speedFactor * velShape;
+            
+            // Hit memory warmth: divide totalPower to slow decay
+            // (higher memoryDecayScale = slower effective decay)
+            totalPower /= memoryDecayScale;
+            
+            float effectiveCoef = expf(totalPower * logBaseDecayCoef);
+            
+            vactrolState *= effectiveCoef;
+            
+            // Denormal clamp
+            if (vactrolState < 0.0001f) vactrolState = 0.0f;
+        }
+        
+        // =====================================================
+        // NONLINEAR TRANSFER: SINGLE STATE → FILTER + VCA
+        // =====================================================
+        //
+        // In the real Buchla 292, one Rf controls both:
+        //   - Filter cutoff: ∝ 1/Rf (drops early as Rf increases)
+        //   - VCA gain: Rα/(Rα + 2Rf) (stays open longer, drops late)
+        //
+        // We model this with transfer curves:
+        //   filterGate = pow(vactrolState, filterExponent)  — drops fast
+        //   vcaGate = sqrt(vactrolState) or similar         — holds open
+        //
+        // The filterExponent is material-dependent, encoding the "pluck"
+        // character that the old dual-envelope tried to create with
+        // separate decay rates. Now it comes from curve shape instead.
+        
+        filterGate = powf(vactrolState, filterExponent);
+        vcaGate = sqrtf(fmaxf(vactrolState, 0.0f));
+        
+        // ...or record it for the next one. The curve ends at silence.
+        if (hitSlot >= 0) {
+            HitCacheFrame frame = { vactrolState, filterGate };
+            if (hitCache->append(hitSlot, hitGeneration, hitPos, frame) && vactrolState > 0.0f) {
+                hitPos++;
+            } else {
+                hitSlot = -1;
+            }
+        }
+    }
+    
+    // Eco: the vactrol advances ecoInterval samples per update (one expf)
+    // and the gates ramp linearly towards the new values in between.
+    // sqrtf is a single instruction on the M7; the filter curve comes from
+    // a table indexed by vcaGate, since pow(s, e) = pow(sqrt(s), 2e).
+    void advanceEnvelopeEco(float& filterGate, float& vcaGate) {
+        if (--rampCountdown <= 0) {
+            rampCountdown = ecoInterval;
+            
+            if (vactrolState > 0.0f) {
+                float speedFactor = 1.0f + vactrolState * vactrolState * vactrolDecayMod;
+                float velShape = 1.0f + (triggerVelocity - 0.5f) * 0.3f * vactrolState;
+                float totalPower = speedFactor * velShape / memoryDecayScale;
+                vactrolState *= expf(totalPower * logBaseDecayCoef * (float)ecoInterval);
+                if (vactrolState < 0.0001f) vactrolState = 0.0f;
+            }
+            
+            startGateRamp(1.0f / (float)ecoInterval);
+        }
+        stepGateRamp(filterGate, vcaGate);
+    }
+    
+    // CV mode: every cvInterval samples the vactrol moves towards the LED
+    // level - up with the material's attack time, down with the same
+    // level-dependent law as a struck decay - and the gates ramp in
+    // between, as in Eco. One expf per interval on the way down only.
+    void advanceEnvelopeCV(float& filterGate, float& vcaGate) {
+        if (--rampCountdown <= 0) {
+            rampCountdown = cvInterval;
+            
+            float target = clampf(ledLevel, 0.0f, 1.0f) * openCeiling;
+            if (target > vactrolState) {
+                vactrolState = target + (vactrolState - target) * cvAttackCoef[material];
+            } else if (vactrolState > 0.0f) {
+                float speedFactor = 1.0f + vactrolState * vactrolState * vactrolDecayMod;
+                float totalPower = speedFactor / memoryDecayScale;
+                vactrolState = target + (vactrolState - target)
+                             * expf(totalPower * logBaseDecayCoef * (float)cvInterval);
+                if (vactrolState < 0.0001f) vactrolState = 0.0f;
+            }
+            
+            startGateRamp(1.0f / (float)cvInterval);
+        }
+        stepGateRamp(filterGate, vcaGate);
+    }
+    
+    // Gate targets for the current vactrol state, reached over the next
+    // interval (or at once, after a trigger or tier change)
+    void startGateRamp(float invInterval) {
+        float vcaTarget = sqrtf(fmaxf(vactrolState, 0.0f));
+        float filterTarget = lookupFilterGate(vcaTarget);
+        if (rampSnap) {
+            rampSnap = false;
+            rampVcaGate = vcaTarget;
+            rampFilterGate = filterTarget;
+            rampVcaStep = rampFilterStep = 0.0f;
+        } else {
+            rampVcaStep = (vcaTarget - rampVcaGate) * invInterval;
+            rampFilterStep = (filterTarget - rampFilterGate) * invInterval;
+        }
+    }
+    
+    void stepGateRamp(float& filterGate, float& vcaGate) {
+        rampVcaGate += rampVcaStep;
+        rampFilterGate += rampFilterStep;
+        vcaGate = rampVcaGate;
+        filterGate = rampFilterGate;
+    }
+    
+    // pow(x, 2 * filterExponent) over x = sqrt(state), state 0..1.2
+    void buildFilterGateTable() {
+        for (int i = 0; i <= kGateTableSize; i++) {
+            float x = (float)i * (kGateTableMax / (float)kGateTableSize);
+            filterGateTable[i] = powf(x, 2.0f * filterExponent);
+        }
+        filterGateTable[kGateTableSize + 1] = filterGateTable[kGateTableSize];
+        gateTableExponent = filterExponent;
+    }
+    
+    float lookupFilterGate(float x) const {
+        float pos = x * ((float)kGateTableSize / kGateTableMax);
+        int idx = (int)pos;
+        if (idx >= kGateTableSize) idx = kGateTableSize;
+        float frac = pos - (float)idx;
+        return filterGateTable[idx] + (filterGateTable[idx + 1] - filterGateTable[idx]) * frac;
+    }
+    
+    void updateDecayFromParam(float decayParam) {
+        // Non-linear scaling for musical response
+        // Maps 0-1 parameter to decay time in milliseconds
+        float baseDecayMs;
+        if (decayParam < 0.05f) {
+            float t = decayParam / 0.05f;
+            baseDecayMs = 5.0f + t * 10.0f;
+        } else if (decayParam < 0.15f) {
+            float t = (decayParam - 0.05f) / 0.10f;
+            baseDecayMs = 15.0f + t * 25.0f;
+        } else if (decayParam < 0.30f) {
+            float t = (decayParam - 0.15f) / 0.15f;
+            baseDecayMs = 40.0f + t * 60.0f;
+        } else if (decayParam < 0.50f) {
+            float t = (decayParam - 0.30f) / 0.20f;
+            baseDecayMs = 100.0f + t * 100.0f;
+        } else if (decayParam < 0.70f) {
+            float t = (decayParam - 0.50f) / 0.20f;
+            baseDecayMs = 200.0f + t * 300.0f;
+        } else if (decayParam < 0.85f) {
+            float t = (decayParam - 0.70f) / 0.15f;
+            baseDecayMs = 500.0f + t * 1000.0f;
+        } else {
+            float t = (decayParam - 0.85f) / 0.15f;
+            baseDecayMs = 1500.0f + t * 3500.0f;
+        }
+        
+        float vcaDecayMs = baseDecayMs * kMaterialDecayMult[material];
+        // NOTE: dampening does NOT affect decay time.
+        // Dampening = hand on drum: reduces brightness + output level.
+        // It's applied in setParams() (brightness) and process() (VCA ceiling).
+        // A dampened drum rings just as long — you just hear less of it.
+        
+        // SINGLE VACTROL DECAY MODEL
+        // One coefficient, one continuous curve. The level-dependent
+        // speed modulation in process() creates the thwack/body contour.
+        float bodySamples = vcaDecayMs * 1.5f * 0.001f * sampleRate;
+        
+        if (bodySamples > 0.0f) {
+            baseDecayCoefficient = expf(-6.9078f / bodySamples);
+            // Pre-compute log for efficient per-sample powf replacement:
+            // powf(coef, speed) = expf(speed * logf(coef))
+            // This saves a logf() call every sample on Cortex-M7
+            logBaseDecayCoef = logf(baseDecayCoefficient);
+        } else {
+            baseDecayCoefficient = 0.0f;
+            logBaseDecayCoef = -100.0f; // large negative → instant decay
+        }
+        
+        // Vactrol level-dependent modulation from material
+        vactrolDecayMod = kMaterialVactrolMod[material];
+        
+        // Filter transfer exponent from material
+        filterExponent = kMaterialFilterExponent[material];
+        if (filterExponent != gateTableExponent) buildFilterGateTable();
+        
+        // A decay change mid-hit makes the rest of this curve unique
+        if (hitSlot >= 0 && (logBaseDecayCoef != hitKey.logDecayCoef || vactrolDecayMod != hitKey.decayMod ||
+                             filterExponent != hitKey.filterExponent)) {
+            hitSlot = -1;
+        }
+    }
+    
+    float sampleRate = 48000.0f;
+    float openCeiling = 1.0f;
+    float baseOpenCeiling = 1.0f;
+    float dampening = 0.0f;
+    float inputGain = 1.0f;
+    float baseDecayParam = 0.5f;
+    MaterialMode material = MATERIAL_NATURAL;
+    bool hitMemoryOn = false;
+    bool bodyOn = false;
+    float bodyTune = 0.0f;
+    float bodyMix = 0.5f;
+    
+    float vactrolState = 0.0f;      // Single vactrol photoresistive state (0=dark, 1=bright)
+    float triggerVelocity = 1.0f;
+    float memoryDecayScale = 1.0f;   // Hit memory warmth: >1 = slower decay from accumulated energy
+    
+    // Single vactrol decay model
+    float baseDecayCoefficient = 0.999f;    // Base decay rate (body/tail speed)
+    float logBaseDecayCoef = -0.001f;       // Pre-computed logf(baseDecayCoef) for Cortex-M7 optimization
+    float vactrolDecayMod = 2.5f;           // Level-dependent speed modulation
+    float filterExponent = 1.8f;            // Nonlinear filter transfer curve
+    
+    float triggerVisual = 0.0f;
+    float triggerVisualDecay = kTriggerVisualDecay;
+    float lastGate = 0.0f;
+    float lastFilterGate = 0.0f;
+    uint32_t outputResets = 0;
+    
+    // Quality tier state
+    static constexpr int kGateTableSize = 64;
+    static constexpr float kGateTableMax = 1.1f;    // > sqrt(1.2), the hit memory ceiling
+    QualityTier quality = QUALITY_STANDARD;
+    
+    // Eco and CV mode envelope: control-rate vactrol, per-sample gate ramps
+    int ecoInterval = 4;
+    int cvInterval = 16;
+    bool cvMode = false;
+    float ledLevel = 0.0f;
+    float cvAttackCoef[3] = { 0.0f, 0.0f, 0.0f };
+    int rampCountdown = 0;
+    bool rampSnap = true;
+    float rampVcaGate = 0.0f, rampVcaStep = 0.0f;
+    float rampFilterGate = 0.0f, rampFilterStep = 0.0f;
+    float filterGateTable[kGateTableSize + 2] = {};
+    float gateTableExponent = -1.0f;
+    
+    // Hit cache: the slot this hit's curve is replayed from / recorded to
+    HitCache* hitCache = nullptr;
+    HitCacheKey hitKey = {};
+    int hitSlot = -1;               // -1: live
+    int hitPos = 0;
+    uint32_t hitGeneration = 0;
+    
+    BuchlaLPGFilter filter;
+    ModalBody body;
+    FXProcessor fx;
+    Oversampler2x oversampler;
+    
+    // Output taps delayed to line up with the HQ oversampled path
+    struct OutputTaps {
+        float highpass;
+        float bandpass;
+        float filterGate;
+        float vcaGate;
+    };
+    OutputTaps tapDelay[kOversampleLatency] = {};
+    OutputTaps delayedTaps = {};
+    int tapPos = 0;
+    bool tapsDelayed = false;
+    DCBlocker dcBlocker;
+    
+#if HM_PROFILE
+    StageProfiler* profiler = nullptr;
+#endif
+};
@@ -0,0 +1,143 @@
+/*
+ * hmEngineApi - see hmEngineApi.h
+ */
+
+#include "hmEngineApi.h"
+#include "hmEngine.h"
+
+#include <stdint.h>
+#include <new>
+
+struct HmVoice {
+    LPGChannel channel;
+    StrikeDetector strike;
+    int controlFrames;      // Samples per control block at this voice's rate
+};
+
+void hmVoiceDefaultParams(HmVoiceParams* params) {
+    params->resonance = 0.0f;
+    params->decay = 0.5f;
+    params->open = 1.0f;
+    params->dampening = 0.0f;
+    params->material = HM_MATERIAL_NATURAL;
+    params->fx = HM_FX_CLEAN;
+    params->fxAmount = 0.0f;
+    params->gain = 1.0f;
+    params->hitMemory = 0;
+    params->quality = HM_QUALITY_STANDARD;
+    params->body = 0;
+    params->bodyTune = 0.0f;
+    params->bodyMix = 0.5f;
+    params->triggerSource = HM_TRIGGER_BUS;
+    params->triggerThreshold = 0.1f;
+}
+
+size_t hmVoiceSize(void) {
+    return sizeof(HmVoice);
+}
+
+size_t hmVoiceAlignment(void) {
+    return alignof(HmVoice);
+}
+
+HmVoice* hmVoiceInit(void* memory, float sampleRate) {
+    if (!memory || ((uintptr_t)memory % alignof(HmVoice)) != 0) return nullptr;
+    
+    HmVoice* voice = new (memory) HmVoice();
+    voice->channel.setSampleRate(sampleRate);
+    voice->strike.setSampleRate(sampleRate);
+    voice->strike.reset();
+    voice->controlFrames = controlInterval(kControlRateHz, sampleRate);
+    
+    HmVoiceParams params;
+    hmVoiceDefaultParams(&params);
+    hmVoiceSetParams(voice, &params);
+    return voice;
+}
+
+void hmVoiceSetParams(HmVoice* voice, const HmVoiceParams* p) {
+    int material = (p->material >= HM_MATERIAL_NATURAL && p->material <= HM_MATERIAL_SOFT)
+                 ? p->material : HM_MATERIAL_NATURAL;
+    int fx = (p->fx >= HM_FX_CLEAN && p->fx <= HM_FX_GRIT) ? p->fx : HM_FX_CLEAN;
+    int quality = (p->quality >= HM_QUALITY_ECO && p->quality <= HM_QUALITY_HQ)
+                ? p->quality : HM_QUALITY_STANDARD;
+    
+    voice->channel.setQuality((QualityTier)quality);
+    voice->channel.setParams(clampf(p->resonance, 0.0f, 1.0f), clampf(p->decay, 0.0f, 1.0f),
+                             clampf(p->open, 0.0f, 1.0f), clampf(p->dampening, 0.0f, 1.0f),
+                             (MaterialMode)material, (FXMode)fx, clampf(p->fxAmount, 0.0f, 1.0f),
+                             p->gain, p->hitMemory != 0);
+    voice->channel.setBody(p->body != 0, clampf(p->bodyTune, -24.0f, 24.0f),
+                           clampf(p->bodyMix, 0.0f, 1.0f));
+    
+    voice->strike.setThreshold(p->triggerThreshold);
+    TriggerSource source = TRIG_SOURCE_BUS;
+    if (p->triggerSource == HM_TRIGGER_AUDIO) source = TRIG_SOURCE_AUDIO;
+    if (p->triggerSource == HM_TRIGGER_CV) source = TRIG_SOURCE_CV;
+    voice->strike.setSource(source);
+    voice->channel.setCVMode(source == TRIG_SOURCE_CV);
+}
+
+void hmVoiceStrike(HmVoice* voice, float velocity) {
+    voice->channel.trigger(clampf(velocity, 0.0f, 1.0f));
+}
+
+void hmVoiceReset(HmVoice* voice) {
+    voice->channel.reset();
+    voice->strike.reset();
+}
+
+// The plugin's per-sample path for one channel: strike detection, then
+// the channel, then the once-per-block state check on what was written
+static void renderVoice(HmVoice* voice, const HmVoiceBuffers& b, int numFrames) {
+    // Audio strikes read the input itself; bus strikes need a trigger buffer
+    bool audioTrigger = (voice->strike.getSource() == TRIG_SOURCE_AUDIO);
+    bool cvGate = (voice->strike.getSource() == TRIG_SOURCE_CV);
+    const float* trig = audioTrigger ? nullptr : b.trigger;
+    
+    for (int chunkStart = 0; chunkStart < numFrames; chunkStart += voice->controlFrames) {
+        int chunkFrames = numFrames - chunkStart;
+        if (chunkFrames > voice->controlFrames) chunkFrames = voice->controlFrames;
+        
+        const float* in = b.in + chunkStart;
+        float* out = b.out + chunkStart;
+        for (int j = 0; j < chunkFrames; ++j) {
+            float vel = 1.0f;
+            StrikeEvent strike = STRIKE_NONE;
+            if (cvGate) {
+                voice->channel.setLED(trig ? trig[chunkStart + j] * 0.2f : 0.0f);
+            } else if (audioTrigger) {
+                strike = voice->strike.process(in[j], vel);
+            } else if (trig) {
+                strike = voice->strike.process(trig[chunkStart + j], vel);
+            }
+            if (strike == STRIKE_FIRE) {
+                voice->channel.trigger(vel, voice->strike.getOffset());
+            } else if (strike == STRIKE_RAISE) {
+                voice->channel.raiseVelocity(vel);
+            }
+            
+            out[j] = voice->channel.process(in[j]);
+            if (b.env) b.env[chunkStart + j] = voice->channel.getOutputGate() * 5.0f;
+            if (b.highpass) b.highpass[chunkStart + j] = voice->channel.getGatedHighpass();
+            if (b.bandpass) b.bandpass[chunkStart + j] = voice->channel.getGatedBandpass();
+            if (b.filterGate) b.filterGate[chunkStart + j] = voice->channel.getOutputFilterGate() * 5.0f;
+        }
+        
+        if (voice->channel.recoverChunk(out, chunkFrames)) {
+            // The taps came from the same bad state
+            if (b.highpass) memset(b.highpass + chunkStart, 0, sizeof(float) * chunkFrames);
+            if (b.bandpass) memset(b.bandpass + chunkStart, 0, sizeof(float) * chunkFrames);
+        }
+    }
+}
+
+void hmProcessVoices(HmVoice* const* voices, const HmVoiceBuffers* buffers,
+                     int numVoices, int numFrames) {
+    // Denormals flush to zero for the whole batch, as they do for step()
+    FlushDenormalsScope flushDenormals;
+    
+    for (int v = 0; v < numVoices; ++v) {
+        renderVoice(voices[v], buffers[v], numFrames);
+    }
+}
@@ -0,0 +1,110 @@
+/*
+ * hmEngineApi - C API over the Holy Mackerel LPG engine
+ *
+ * One voice = one LPG channel with its own strike detector, exactly the
+ * per-sample path the Disting NT plugin runs for its left channel. The
+ * caller owns all memory: ask hmVoiceSize()/hmVoiceAlignment(), hand a
+ * block to hmVoiceInit(), and nothing is ever allocated afterwards.
+ * hmProcessVoices() renders whole buffers for any number of voices in one
+ * call.
+ *
+ * Not thread-safe per voice; different voices may be processed on
+ * different threads.
+ */
+
+#pragma once
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct HmVoice HmVoice;
+
+enum {
+    HM_MATERIAL_NATURAL = 0,
+    HM_MATERIAL_HARD = 1,
+    HM_MATERIAL_SOFT = 2
+};
+
+enum {
+    HM_FX_CLEAN = 0,
+    HM_FX_TUBE = 1,
+    HM_FX_SCREAMER = 2,
+    HM_FX_GRIT = 3
+};
+
+enum {
+    HM_QUALITY_ECO = 0,
+    HM_QUALITY_STANDARD = 1,
+    HM_QUALITY_HQ = 2
+};
+
+enum {
+    HM_TRIGGER_BUS = 0,         // HmVoiceBuffers.trigger is a trigger voltage
+    HM_TRIGGER_AUDIO = 1,       // Strikes come from onsets in HmVoiceBuffers.in
+    HM_TRIGGER_CV = 2           // HmVoiceBuffers.trigger drives the vactrol LED, 0-5V
+};
+
+// Same ranges and meaning as the plugin parameters, normalised:
+// percentages are 0-1, the threshold is in volts, gain is linear.
+typedef struct HmVoiceParams {
+    float resonance;
+    float decay;
+    float open;
+    float dampening;
+    int material;               // HM_MATERIAL_*
+    int fx;                     // HM_FX_*
+    float fxAmount;
+    float gain;                 // 1 = unity
+    int hitMemory;              // 0 / 1
+    int quality;                // HM_QUALITY_*
+    int body;                   // 0 / 1
+    float bodyTune;             // Semitones, -24 to +24
+    float bodyMix;
+    int triggerSource;          // HM_TRIGGER_*
+    float triggerThreshold;     // Volts, 0.01-0.5
+} HmVoiceParams;
+
+// Buffers for one voice over one hmProcessVoices() call, numFrames long.
+// trigger may be NULL (no bus strikes); env and the filter taps may be NULL.
+// env and the taps line up with out, including the oversampler's latency
+// in HM_QUALITY_HQ.
+typedef struct HmVoiceBuffers {
+    const float* in;            // Audio in, volts
+    const float* trigger;       // Trigger voltage or LED CV (HM_TRIGGER_BUS / _CV)
+    float* out;                 // Written, not added to
+    float* env;                 // Vactrol VCA gate, 0-5V
+    float* highpass;            // SVF highpass through the VCA (pre-body, pre-FX)
+    float* bandpass;            // SVF bandpass through the VCA
+    float* filterGate;          // Vactrol filter gate, 0-5V
+} HmVoiceBuffers;
+
+// The plugin's parameter defaults
+void hmVoiceDefaultParams(HmVoiceParams* params);
+
+// Memory one voice needs, and its required alignment
+size_t hmVoiceSize(void);
+size_t hmVoiceAlignment(void);
+
+// Builds a voice in caller memory (hmVoiceSize() bytes, suitably aligned)
+// with default parameters. Returns NULL if memory is NULL or misaligned.
+HmVoice* hmVoiceInit(void* memory, float sampleRate);
+
+void hmVoiceSetParams(HmVoice* voice, const HmVoiceParams* params);
+
+// Strikes the voice at the start of the next hmProcessVoices() call, as a
+// MIDI note-on does in the plugin. velocity 0-1.
+void hmVoiceStrike(HmVoice* voice, float velocity);
+
+// Back to silence, detectors re-armed
+void hmVoiceReset(HmVoice* voice);
+
+// Renders numFrames samples for each voice. buffers[i] belongs to voices[i].
+void hmProcessVoices(HmVoice* const* voices, const HmVoiceBuffers* buffers,
+                     int numVoices, int numFrames);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,443 @@
+/*
+ * hmReference - slow, plain per-sample reference kernels
+ *
+ * The filter, FX and channel paths of hmEngine.h as straightforward
+ * per-sample code, kept as the behavioural spec that the optimized kernels
+ * are checked against (host/hmfuzz). Everything is derived where it is
+ * used:
+ *   - no held or control-rate coefficients
+ *   - no lookup tables
+ *   - no ramps
+ * The Eco tier and CV mode become per-sample here too.
+ *
+ * The fast approximations that define the sound (ref_fast_tanh,
+ * ref_fast_tan) are frozen copies. A change to the engine's math
+ * therefore shows up as a divergence rather than moving the reference
+ * along with it.
+ *
+ * Shared with the engine unchanged, because they have no optimized
+ * variant to check: the modal body, the 2x oversampler and the DC blocker.
+ *
+ * Not for real-time use. Edit only on purpose, when the intended sound
+ * changes.
+ */
+
+#pragma once
+
+#include "hmEngine.h"
+
+// ============================================================================
+// FROZEN MATH - Copies of the engine's approximations as of this reference
+// ============================================================================
+
+static inline float ref_fast_tanh(float x) {
+    if (x < -3.0f) return -1.0f;
+    if (x > 3.0f) return 1.0f;
+    float x2 = x * x;
+    return x * (27.0f + x2) / (27.0f + 9.0f * x2);
+}
+
+static inline float ref_fast_tan(float x) {
+    float x2 = x * x;
+    float p = 2.46730317f + x2 * (-0.176852237f + x2 * -0.0050564034f);
+    return x * p / (2.46740110f - x2);
+}
+
+static inline float ref_soft_saturate(float x, float knee) {
+    float ax = fabsf(x);
+    if (ax < knee) return x;
+    float sign = x > 0.0f ? 1.0f : -1.0f;
+    return sign * (knee + (1.0f - knee) * ref_fast_tanh((ax - knee) / (1.0f - knee)));
+}
+
+// ============================================================================
+// REFERENCE FILTER - SVF with every coefficient derived per sample
+// ============================================================================
+
+class ReferenceFilter {
+public:
+    void setSampleRate(float sr) {
+        sampleRate = sr;
+        maxCutoff = sr * 0.45f;
+    }
+    
+    void setResonance(float res) { resonance = clampf(res, 0.0f, 1.0f); }
+    void setBrightness(float bright) { brightness = clampf(bright, 0.1f, 2.0f); }
+    
+    float process(float input, float filterGate, float vcaGate) {
+        float q = 0.5f + resonance * resonance * 24.5f;
+        float k = 1.0f / q;
+        float resMakeupGain = 1.0f;
+        if (resonance > 0.15f) {
+            float r = resonance - 0.15f;
+            resMakeupGain = 1.0f + r * r * 4.0f;
+        }
+        float bpMixAmount = resonance * resonance * 0.5f;
+        float bypassMix = (resonance < 0.1f) ? (1.0f - resonance / 0.1f) * 0.5f : 0.0f;
+        
+        float targetCutoff = clampf(20.0f + filterGate * brightness * (maxCutoff - 20.0f), 20.0f, maxCutoff);
+        smoothedCutoff += (targetCutoff - smoothedCutoff) * 0.35f;
+        float w = TWO_PI * smoothedCutoff / sampleRate;
+        float g = fmaxf(ref_fast_tan(w * 0.5f), 0.0001f);
+        
+        float hp = (input - (2.0f * k + g) * s1 - s2) / (1.0f + g * (g + 2.0f * k));
+        float bp = g * hp + s1;
+        float lp = g * bp + s2;
+        
+        s1 = clampf(ref_soft_saturate(g * hp + bp, 0.9f), -4.0f, 4.0f);
+        s2 = clampf(ref_soft_saturate(g * bp + lp, 0.9f), -4.0f, 4.0f);
+        if (vcaGate < 0.01f) {
+            s1 *= 0.995f;
+            s2 *= 0.995f;
+        }
+        
+        float output = (lp + bp * bpMixAmount) * vcaGate * resMakeupGain;
+        if (bypassMix > 0.0f) output = lerpf(output, input * vcaGate, bypassMix);
+        
+        lastHP = hp;
+        lastBP = bp;
+        return ref_soft_saturate(output, 0.95f);
+    }
+    
+    float getHighpass() const { return lastHP; }
+    float getBandpass() const { return lastBP; }
+    float getCutoff() const { return smoothedCutoff; }
+    void reset() { s1 = s2 = lastHP = lastBP = 0.0f; smoothedCutoff = 20.0f; }
+    void dampStateOnRetrigger() { s1 *= 0.5f; s2 *= 0.5f; }
+
+private:
+    float sampleRate = 48000.0f;
+    float maxCutoff = 20000.0f;
+    float brightness = 1.0f;
+    float resonance = 0.0f;
+    float s1 = 0.0f, s2 = 0.0f;
+    float smoothedCutoff = 20.0f;
+    float lastHP = 0.0f;
+    float lastBP = 0.0f;
+};
+
+// ============================================================================
+// REFERENCE FX - Mode and amount curves evaluated on every sample
+// ============================================================================
+
+class ReferenceFX {
+public:
+    void setSampleRate(float sr, int oversampling = 1) {
+        float rate = sr * (float)oversampling;
+        float w = TWO_PI * 720.0f / rate;
+        screamerHPCoef = 1.0f - expf(-w);
+        screamerLPCoef = 1.0f - expf(-w);
+        gritLPCoef = 1.0f - expf(-TWO_PI * 4000.0f / rate);
+        tubeGridDecay = powf(0.9998f, 1.0f / (float)oversampling);
+        tubeDCCoef = powf(0.995f, 1.0f / (float)oversampling);
+        gritHoldScale = (float)oversampling;
+    }
+    
+    void setMode(FXMode m) { mode = m; }
+    void setAmount(float amt) { amount = clampf(amt, 0.0f, 1.0f); }
+    bool isActive() const { return mode != FX_CLEAN; }
+    
+    float process(float input, float gate) {
+        if (mode == FX_CLEAN || amount < 0.01f) return input;
+        
+        float amt;
+        if (amount < 0.3f) {
+            amt = amount * 0.3f;
+        } else if (amount < 0.7f) {
+            amt = 0.09f + (amount - 0.3f) * 1.0f;
+        } else {
+            amt = 0.49f + (amount - 0.7f) * 1.7f;
+        }
+        
+        float wet = input;
+        float makeup = 1.0f;
+        if (mode == FX_TUBE) {
+            wet = tube(input, gate, amt);
+            makeup = 1.4f + amt * 0.4f;
+        } else if (mode == FX_SCREAMER) {
+            wet = screamer(input, amt);
+            makeup = 1.6f + amt * 0.6f;
+        } else if (mode == FX_GRIT) {
+            wet = grit(input, amt);
+            makeup = 1.8f + amt * 0.8f;
+        }
+        return lerpf(input, wet * makeup, amount);
+    }
+    
+    void reset() {
+        tubeGridState = tubeDCPrev = tubeDCOut = 0.0f;
+        screamerHP_z = screamerLP_z = 0.0f;
+        gritLP_z = gritHold = gritCounter = gritFeedback = 0.0f;
+    }
+
+private:
+    float tube(float x, float gate, float amt) {
+        x *= 1.5f + amt * 6.0f * (0.5f + gate * 0.5f);
+        x += amt * 0.18f;
+        
+        float out;
+        if (x > 0.0f) {
+            out = x / (1.0f + x * (0.3f + amt * 0.5f));
+        } else {
+            out = x / (1.0f - x * (0.15f + amt * 0.25f));
+        }
+        out += x * fabsf(x) * 0.2f * amt;
+        
+        if (amt > 0.4f && x > 0.5f) {
+            tubeGridState -= ref_fast_tanh((x - 0.5f) * 3.0f) * 0.0005f * amt;
+        }
+        tubeGridState *= tubeGridDecay;
+        out += tubeGridState;
+        
+        float dcBlocked = out - tubeDCPrev + tubeDCCoef * tubeDCOut;
+        tubeDCPrev = out;
+        tubeDCOut = dcBlocked;
+        return dcBlocked;
+    }
+    
+    float screamer(float x, float amt) {
+        float hp = x - screamerHP_z;
+        screamerHP_z += screamerHPCoef * (x - screamerHP_z);
+        
+        float gained = hp * (6.0f + amt * 50.0f) + x * (0.35f + (1.0f - amt) * 0.25f);
+        float clipped = gained;
+        if (gained > 0.5f) {
+            clipped = 0.5f + ref_fast_tanh((gained - 0.5f) * 2.0f) * 0.4f;
+        } else if (gained < -0.5f) {
+            clipped = -0.5f + ref_fast_tanh((gained + 0.5f) * 2.0f) * 0.4f;
+        }
+        
+        screamerLP_z += screamerLPCoef * (clipped - screamerLP_z);
+        return screamerLP_z * (1.0f + amt * 0.5f);
+    }
+    
+    float grit(float x, float amt) {
+        float fuzzed = x * (2.0f + amt * 15.0f);
+        float rectify = amt * 0.3f;
+        fuzzed = fuzzed * (1.0f - rectify) + fabsf(fuzzed) * rectify;
+        fuzzed -= gritFeedback * amt * 0.4f;
+        fuzzed += 0.15f * amt;
+        
+        if (fuzzed > 0.3f) {
+            fuzzed = 0.3f + ref_fast_tanh((fuzzed - 0.3f) * 3.0f) * 0.4f;
+        } else if (fuzzed < -0.5f) {
+            fuzzed = -0.5f + ref_fast_tanh((fuzzed + 0.5f) * 2.0f) * 0.3f;
+        }
+        
+        float crushed = fuzzed;
+        if (amt > 0.3f) {
+            float levels = powf(2.0f, 10.0f - (amt - 0.3f) / 0.7f * 7.0f);
+            crushed = floorf(fuzzed * levels + 0.5f) / levels;
+            if (amt > 0.5f) {
+                float holdLength = (1.0f + (amt - 0.5f) * 12.0f) * gritHoldScale;
+                gritCounter += 1.0f;
+                if (gritCounter >= holdLength) {
+                    gritCounter -= holdLength;
+                    gritHold = crushed;
+                }
+                crushed = gritHold;
+            }
+        }
+        
+        crushed -= ref_fast_tanh(gritFeedback * amt * 3.0f) * 0.3f * amt;
+        gritFeedback = crushed;
+        
+        gritLP_z += gritLPCoef * (crushed - gritLP_z);
+        float dryMix = 0.15f * (1.0f - amt * 0.5f);
+        return gritLP_z * (1.0f - dryMix) + x * dryMix;
+    }
+    
+    FXMode mode = FX_CLEAN;
+    float amount = 0.0f;
+    float tubeGridState = 0.0f, tubeDCPrev = 0.0f, tubeDCOut = 0.0f;
+    float tubeGridDecay = 0.9998f, tubeDCCoef = 0.995f;
+    float screamerHP_z = 0.0f, screamerLP_z = 0.0f;
+    float screamerHPCoef = 0.1f, screamerLPCoef = 0.1f;
+    float gritLP_z = 0.0f, gritHold = 0.0f, gritCounter = 0.0f, gritFeedback = 0.0f;
+    float gritLPCoef = 0.5f;
+    float gritHoldScale = 1.0f;
+};
+
+// ============================================================================
+// REFERENCE CHANNEL - Vactrol, filter, body, FX; every tier per sample
+//
+// Same interface as LPGChannel for what the fuzzer drives. The tier only
+// picks what the shared components do (body mode count, FX oversampling);
+// the envelope is the per-sample law on every tier, CV mode included.
+// ============================================================================
+
+class ReferenceChannel {
+public:
+    void setSampleRate(float sr) {
+        sampleRate = sr;
+        filter.setSampleRate(sr);
+        fx.setSampleRate(sr, quality == QUALITY_HQ ? 2 : 1);
+        body.setSampleRate(sr);
+    }
+    
+    void setQuality(QualityTier tier) {
+        if (tier == quality) return;
+        bool oversampleChanged = (tier == QUALITY_HQ) != (quality == QUALITY_HQ);
+        quality = tier;
+        body.setQuality(tier);
+        if (oversampleChanged) {
+            fx.setSampleRate(sampleRate, tier == QUALITY_HQ ? 2 : 1);
+            fx.reset();
+            oversampler.reset();
+        }
+    }
+    
+    void setParams(float resonance, float decayParam, float openParam, float damp,
+                   MaterialMode mat, FXMode fxMode, float fxAmount, float gain, bool hitMemory) {
+        baseOpenCeiling = openCeiling = openParam;
+        dampening = damp;
+        material = mat;
+        inputGain = gain;
+        hitMemoryOn = hitMemory;
+        baseDecayParam = decayParam;
+        setDecay(decayParam);
+        
+        filter.setResonance(resonance * (1.0f - damp * 0.4f));
+        filter.setBrightness(kMaterialBrightness[mat] * (1.0f - damp * 0.85f));
+        // Switching FX on starts the HQ oversampler from silence
+        bool fxWasActive = fx.isActive();
+        fx.setMode(fxMode);
+        fx.setAmount(fxAmount);
+        if (fx.isActive() && !fxWasActive) oversampler.reset();
+        if (bodyOn) body.configure(mat, decayParam, bodyTune);
+    }
+    
+    void setBody(bool on, float tuneSemitones, float mix) {
+        if (on && !bodyOn) body.reset();
+        bodyOn = on;
+        bodyTune = tuneSemitones;
+        bodyMix = mix;
+        if (on) body.configure(material, baseDecayParam, tuneSemitones);
+    }
+    
+    void updateCV(float decayMod, float openMod) {
+        openCeiling = clampf(baseOpenCeiling + openMod, 0.0f, 1.0f);
+        setDecay(clampf(baseDecayParam + decayMod, 0.0f, 1.0f));
+    }
+    
+    void setCVMode(bool on) {
+        if (on == cvMode) return;
+        cvMode = on;
+        ledLevel = 0.0f;
+    }
+    void setLED(float level) { ledLevel = level; }
+    
+    void trigger(float velocity = 1.0f, float offset = 0.0f) {
+        float targetLevel = velocity * openCeiling;
+        if (hitMemoryOn) {
+            float previousState = vactrolState;
+            targetLevel = clampf(vactrolState + targetLevel, 0.0f, 1.2f);
+            memoryDecayScale = 1.0f + clampf(previousState * 0.4f, 0.0f, 0.4f);
+        } else {
+            memoryDecayScale = 1.0f;
+        }
+        vactrolState = targetLevel;
+        if (offset > 0.0f) {
+            float speedFactor = 1.0f + targetLevel * targetLevel * vactrolDecayMod;
+            float velShape = 1.0f + (velocity - 0.5f) * 0.3f * targetLevel;
+            vactrolState *= expf(offset * speedFactor * velShape / memoryDecayScale * logDecayCoef);
+        }
+        triggerVelocity = velocity;
+        filter.dampStateOnRetrigger();
+    }
+    
+    void raiseVelocity(float velocity) {
+        if (velocity <= triggerVelocity) return;
+        vactrolState = clampf(vactrolState + (velocity - triggerVelocity) * openCeiling, 0.0f, 1.2f);
+        triggerVelocity = velocity;
+    }
+    
+    float process(float input) {
+        if (cvMode) {
+            // Towards the LED level: the material's attack going up, the
+            // struck decay law coming down
+            float target = clampf(ledLevel, 0.0f, 1.0f) * openCeiling;
+            if (target > vactrolState) {
+                float attackCoef = expf(-1.0f / (kMaterialAttackTime[material] * sampleRate));
+                vactrolState = target + (vactrolState - target) * attackCoef;
+            } else if (vactrolState > 0.0f) {
+                float speedFactor = 1.0f + vactrolState * vactrolState * vactrolDecayMod;
+                vactrolState = target + (vactrolState - target) * expf(speedFactor / memoryDecayScale * logDecayCoef);
+                if (vactrolState < 0.0001f) vactrolState = 0.0f;
+            }
+        } else if (vactrolState > 0.0f) {
+            float speedFactor = 1.0f + vactrolState * vactrolState * vactrolDecayMod;
+            float velShape = 1.0f + (triggerVelocity - 0.5f) * 0.3f * vactrolState;
+            vactrolState *= expf(speedFactor * velShape / memoryDecayScale * logDecayCoef);
+            if (vactrolState < 0.0001f) vactrolState = 0.0f;
+        }
+        
+        float filterGate = powf(vactrolState, kMaterialFilterExponent[material]);
+        float vcaGate = sqrtf(fmaxf(vactrolState, 0.0f)) * (1.0f - dampening * 0.75f);
+        if (vcaGate < 0.001f) vcaGate = 0.0f;
+        if (filterGate < 0.001f) filterGate = 0.0f;
+        lastGate = vcaGate;
+        lastFilterGate = filterGate;
+        
+        float filtered = filter.process(input * inputGain, filterGate, vcaGate);
+        if (bodyOn) filtered += bodyMix * (body.process(filtered, vcaGate) - filtered);
+        
+        float processed;
+        if (quality == QUALITY_HQ && fx.isActive()) {
+            float even, odd;
+            oversampler.upsample(filtered, even, odd);
+            even = fx.process(even, vcaGate);
+            odd = fx.process(odd, vcaGate);
+            processed = oversampler.downsample(even, odd);
+        } else {
+            processed = fx.process(filtered, vcaGate);
+        }
+        return ref_soft_saturate(dcBlocker.process(processed), 0.98f);
+    }
+    
+    float getGateValue() const { return lastGate; }
+    float getFilterGate() const { return lastFilterGate; }
+    float getGatedHighpass() const { return filter.getHighpass() * lastGate; }
+    float getGatedBandpass() const { return filter.getBandpass() * lastGate; }
+
+private:
+    void setDecay(float decayParam) {
+        // Decay knob to milliseconds: piecewise linear through these points
+        static const float kKnob[] = { 0.0f, 0.05f, 0.15f, 0.30f, 0.50f, 0.70f, 0.85f, 1.0f };
+        static const float kMs[] = { 5.0f, 15.0f, 40.0f, 100.0f, 200.0f, 500.0f, 1500.0f, 5000.0f };
+        int seg = 0;
+        while (seg < 6 && decayParam >= kKnob[seg + 1]) seg++;
+        float t = (decayParam - kKnob[seg]) / (kKnob[seg + 1] - kKnob[seg]);
+        float decayMs = kMs[seg] + t * (kMs[seg + 1] - kMs[seg]);
+        
+        float decaySamples = decayMs * kMaterialDecayMult[material] * 1.5f * 0.001f * sampleRate;
+        logDecayCoef = (decaySamples > 0.0f) ? logf(expf(-6.9078f / decaySamples)) : -100.0f;
+        vactrolDecayMod = kMaterialVactrolMod[material];
+    }
+    
+    float sampleRate = 48000.0f;
+    QualityTier quality = QUALITY_STANDARD;
+    float openCeiling = 1.0f, baseOpenCeiling = 1.0f;
+    float dampening = 0.0f;
+    float inputGain = 1.0f;
+    float baseDecayParam = 0.5f;
+    MaterialMode material = MATERIAL_NATURAL;
+    bool hitMemoryOn = false;
+    bool bodyOn = false;
+    float bodyTune = 0.0f, bodyMix = 0.5f;
+    bool cvMode = false;
+    float ledLevel = 0.0f;
+    
+    float vactrolState = 0.0f;
+    float triggerVelocity = 1.0f;
+    float memoryDecayScale = 1.0f;
+    float logDecayCoef = -0.001f;
+    float vactrolDecayMod = 2.5f;
+    float lastGate = 0.0f, lastFilterGate = 0.0f;
+    
+    ReferenceFilter filter;
+    ReferenceFX fx;
+    ModalBody body;
+    Oversampler2x oversampler;
+    DCBlocker dcBlocker;
+};
@@ -105,863 +105,467 @@
 #include <new>
 #include <distingnt/api.h>
 
-#ifndef ARRAY_SIZE
-#define ARRAY_SIZE(x) (sizeof(x) / sizeof((x)[0]))
-#endif
-
-static constexpr float PI = 3.14159265358979323846f;
-static constexpr float TWO_PI = 6.28318530717958647692f;
+#include "engine/hmEngine.h"
 
 // ============================================================================
-// UTILITY FUNCTIONS
-// ============================================================================
-
-static inline float clampf(float x, float lo, float hi) {
-    return x < lo ? lo : (x > hi ? hi : x);
-}
-
-static inline float lerpf(float a, float b, float t) {
-    return a + (b - a) * clampf(t, 0.0f, 1.0f);
-}
-
-static inline float fast_tanh(float x) {
-    if (x < -3.0f) return -1.0f;
-    if (x > 3.0f) return 1.0f;
-    float x2 = x * x;
-    return x * (27.0f + x2) / (27.0f + 9.0f * x2);
-}
-
-static inline float soft_saturate(float x, float knee) {
-    float ax = fabsf(x);
-    if (ax < knee) return x;
-    float sign = x > 0.0f ? 1.0f : -1.0f;
-    return sign * (knee + (1.0f - knee) * fast_tanh((ax - knee) / (1.0f - knee)));
-}
-
-// ============================================================================
-// MATERIAL MODES
+// BUS CAPTURE - Streaming record of everything step() reads
+// (build with -DHM_CAPTURE=1)
+//
+// Records the input buses, the parameter timeline and incoming MIDI into a caller-provided
+// buffer (DRAM on the module) so a session can be replayed block-for-block
+// on the host. Capture starts from a freshly reset DSP state and runs until
+// the buffer is full.
+//
+// Stream format, little endian, one record after another:
+//   Header   "HMCP" u16 version u16 numParams f32 sampleRate i16 v[numParams]
+//   'P'      u16 param  i16 value               - parameter change, applied
+//                                                 before the next block
+//   'M'      u8 status u8 data1 u8 data2         - MIDI message, delivered
+//                                                 before the next block
+//   'B'      u16 numFrames u16 roleMask          - one block of input; for each
+//            f32 samples[numFrames] per role       set bit in CaptureRole order
+//   'H'      u32 hash                            - FNV-1a over the output buses
+//                                                 after step(), for replay checks
+//
+// Output buses in Add mode are captured before step() too, so replay can
+// rebuild the exact bus contents the block was mixed into.
 // ============================================================================
 
-enum MaterialMode {
-    MATERIAL_NATURAL = 0,
-    MATERIAL_HARD = 1,
-    MATERIAL_SOFT = 2
-};
-
-// Attack times in seconds
-static const float kMaterialAttackTime[3] = {
-    0.005f,     // Natural - 5ms (wood/organic)
-    0.0005f,    // Hard - 0.5ms (metal/glass — instant, sharp transient)
-    0.020f      // Soft - 20ms (rubber/felt — rounded, gentle)
-};
+#ifndef HM_CAPTURE
+#define HM_CAPTURE 0
+#endif
 
-// Decay multipliers — how long the material rings
-// Hard materials RING LONGER (metal sustains), soft materials ABSORB (rubber deadens)
-static const float kMaterialDecayMult[3] = {
-    1.0f,       // Natural - baseline
-    1.4f,       // Hard - metal/glass RINGS, longer sustain
-    0.7f        // Soft - rubber/felt absorbs, shorter sustain
-};
+#ifndef HM_CAPTURE_BYTES
+#define HM_CAPTURE_BYTES (4u << 20)
+#endif
 
-// Filter brightness (affects cutoff range)
-// Hard = bright and shimmery, Soft = dark and thuddy
-static const float kMaterialBrightness[3] = {
-    1.0f,       // Natural - full range
-    1.8f,       // Hard - bright, lots of upper harmonics
-    0.35f       // Soft - dark, muted
-};
+static constexpr uint16_t kCaptureVersion = 3;     // 2: adds 'M' records, 3: filter/gate output roles
 
-// Vactrol level-dependent decay modulation
-// LOW values = uniform/ringing decay (metal), HIGH = fast initial drop (thud)
-static const float kMaterialVactrolMod[3] = {
-    2.5f,       // Natural - balanced thwack and body
-    1.2f,       // Hard - low modulation = even ring, shimmer sustain
-    4.0f        // Soft - high modulation = fast thwack, quick deadening
+enum CaptureRecord {
+    CAPTURE_PARAM = 'P',
+    CAPTURE_MIDI = 'M',
+    CAPTURE_BLOCK = 'B',
+    CAPTURE_HASH = 'H'
 };
 
-// Filter transfer curve exponent (from single vactrol state)
-// LOW = filter stays open (bright ringing), HIGH = filter closes fast (dark thud)
-static const float kMaterialFilterExponent[3] = {
-    1.8f,       // Natural - classic LPG pluck
-    1.2f,       // Hard - filter stays open = bright metallic ring
-    2.8f        // Soft - filter closes fast = dark, muted, felt-like
+// Bus roles in the order their samples appear in a 'B' record
+enum CaptureRole {
+    CAP_LEFT_IN = 0,
+    CAP_RIGHT_IN,
+    CAP_TRIGGER,
+    CAP_RES_CV,
+    CAP_DECAY_CV,
+    CAP_OPEN_CV,
+    CAP_DAMP_CV,
+    CAP_FX_CV,
+    CAP_LEFT_OUT,       // Pre-step contents, Add mode only
+    CAP_RIGHT_OUT,      // Pre-step contents, Add mode only
+    CAP_HP_OUT,         // Pre-step contents, Add mode only
+    CAP_BP_OUT,         // Pre-step contents, Add mode only
+    CAP_FILTER_GATE_OUT,    // Pre-step contents, Add mode only
+    CAP_VCA_GATE_OUT,       // Pre-step contents, Add mode only
+    kNumCaptureRoles
 };
 
-// ============================================================================
-// FX MODES
-// ============================================================================
+// FNV-1a over the raw float bits - any single-bit difference shows
+static inline uint32_t captureHash(uint32_t h, const float* data, int numFrames) {
+    const uint8_t* bytes = (const uint8_t*)data;
+    for (int i = 0; i < numFrames * 4; i++) {
+        h ^= bytes[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+static constexpr uint32_t kCaptureHashSeed = 2166136261u;
 
-enum FXMode {
-    FX_CLEAN = 0,
-    FX_TUBE = 1,
-    FX_SCREAMER = 2,
-    FX_GRIT = 3
-};
+#if HM_CAPTURE
 
-// ============================================================================
-// LPG FILTER — Buchla 292-inspired SVF
-// 
-// Clean SVF with resonance that preserves bass through bandpass mixing
-// and makeup gain. NO level-dependent gain compensation (which caused
-// the double-hit artifact in the "Smile Pass" era).
-// ============================================================================
+#define HM_CAPTURE_DO(x) x
 
-class BuchlaLPGFilter {
+class BusCapture {
 public:
-    void setSampleRate(float sr) {
-        sampleRate = sr;
-        maxCutoff = sr * 0.45f;
+    void init(uint8_t* memory, uint32_t size) {
+        buffer = memory;
+        capacity = size;
+        used = 0;
+        full = true;    // Nothing recorded until start()
     }
     
-    void setResonance(float res) {
-        resonance = clampf(res, 0.0f, 1.0f);
-        
-        // Q range: 0.5 (gentle) to 25 (self-oscillation territory)
-        float q = 0.5f + res * res * 24.5f;
-        k = 1.0f / q;
-        
-        // Resonance makeup gain — compensates for the SVF's LP output
-        // losing broadband energy at high Q (energy concentrates at resonant peak).
-        // This is STATIC per resonance setting, NOT level-dependent.
-        // Safe because it doesn't change during decay (unlike the old Smile Pass).
-        if (res > 0.15f) {
-            float r = res - 0.15f;
-            resMakeupGain = 1.0f + r * r * 4.0f;  // Aggressive makeup at high res
-        } else {
-            resMakeupGain = 1.0f;
-        }
-        
-        // How much bandpass to mix in — the resonant peak itself
-        // At high resonance the BP is where all the action is
-        bpMixAmount = res * res * 0.5f;
+    // Writes the header; the caller resets DSP state so replay starts equal
+    void start(float sampleRate, const int16_t* v, int numParams) {
+        used = 0;
+        full = false;
+        numBlocks = 0;
+        droppedEvents = 0;
+        eventTail = eventHead;  // Discard changes from before the snapshot
+        uint16_t version = kCaptureVersion;
+        uint16_t n = (uint16_t)numParams;
+        if (!reserve(4 + 2 + 2 + 4 + 2 * n)) return;
+        put("HMCP", 4);
+        put(&version, 2);
+        put(&n, 2);
+        put(&sampleRate, 4);
+        put(v, 2 * n);
     }
     
-    void setBrightness(float bright) {
-        brightness = clampf(bright, 0.1f, 2.0f);
+    // Control thread - single producer. Drained into the stream by step().
+    void queueParam(int p, int16_t value) {
+        uint16_t param = (uint16_t)p;
+        uint8_t payload[4];
+        memcpy(payload, &param, 2);
+        memcpy(payload + 2, &value, 2);
+        queueEvent(CAPTURE_PARAM, payload, 4);
     }
     
-    float process(float input, float filterGate, float vcaGate) {
-        // At very low resonance, blend toward bypass for clean tone
-        float bypassMix = (resonance < 0.1f) ? (1.0f - resonance / 0.1f) * 0.5f : 0.0f;
-        
-        // Target cutoff follows filter gate
-        float minCutoff = 20.0f;
-        float targetCutoff = minCutoff + filterGate * brightness * (maxCutoff - minCutoff);
-        targetCutoff = clampf(targetCutoff, minCutoff, maxCutoff);
-        
-        // Cutoff tracking — the vactrol model already produces a smooth,
-        // continuous decay curve. We only need minimal smoothing to prevent
-        // coefficient discontinuity at the SVF, NOT to shape the envelope.
-        // 
-        // CRITICAL: The old asymmetric smoother (0.4 open / 0.03 close)
-        // caused the filter to STAY OPEN for ~4ms after the VCA started
-        // dropping, creating a timbral plateau that the ear perceived as
-        // a double-hit: first a volume drop, then a delayed brightness drop.
-        //
-        // Fix: use fast uniform tracking. The vactrol IS the smoother.
-        float smoothCoef = 0.35f;  // Fast tracking both directions
-        smoothedCutoff += (targetCutoff - smoothedCutoff) * smoothCoef;
-        float cutoff = smoothedCutoff;
-        
-        // SVF coefficients - fast_tanh is cheaper on Cortex-M7 and naturally
-        // bounded, preventing the extreme values tanf() produces near Nyquist
-        // that cause filter blowup during rapid retriggering
-        float w = TWO_PI * cutoff / sampleRate;
-        float g = fast_tanh(w * 0.5f);
-        g = clampf(g, 0.0001f, 0.9999f);
-        
-        // Two-pole SVF
-        float hp = (input - (2.0f * k + g) * s1 - s2) / (1.0f + g * (g + 2.0f * k));
-        float bp = g * hp + s1;
-        float lp = g * bp + s2;
-        
-        // Update state with gentle saturation
-        s1 = soft_saturate(g * hp + bp, 0.9f);
-        s2 = soft_saturate(g * bp + lp, 0.9f);
-        
-        // Hard energy limit - prevents accumulation during rapid retriggers
-        // that caused crash after ~8 triggers in v7.0
-        s1 = clampf(s1, -4.0f, 4.0f);
-        s2 = clampf(s2, -4.0f, 4.0f);
-        
-        // NaN protection - if anything goes sideways, reset cleanly
-        if (!(s1 == s1) || !(s2 == s2)) { // NaN check
-            s1 = s2 = 0.0f;
-            smoothedCutoff = 20.0f;
+    // MIDI arrives on the same control path as parameter changes, so the
+    // two stay in order in one queue
+    void queueMidi(uint8_t byte0, uint8_t byte1, uint8_t byte2) {
+        uint8_t payload[3] = { byte0, byte1, byte2 };
+        queueEvent(CAPTURE_MIDI, payload, 3);
+    }
+    
+    // Audio thread - before processing. buses[role] is null for unused roles.
+    void recordBlock(const float* const* buses, int numFrames) {
+        while (eventTail != eventHead) {
+            const QueuedEvent& e = eventQueue[eventTail];
+            if (!full && reserve(1 + e.size)) {
+                put(&e.tag, 1);
+                put(e.payload, e.size);
+            }
+            eventTail = (eventTail + 1) & (kEventQueueSize - 1);
         }
-        
-        // When gate is very low, gently decay filter state
-        if (vcaGate < 0.01f) {
-            s1 *= 0.995f;
-            s2 *= 0.995f;
+        if (full) return;
+        
+        uint16_t mask = 0;
+        int numRoles = 0;
+        for (int r = 0; r < kNumCaptureRoles; r++) {
+            if (buses[r]) {
+                mask |= (uint16_t)(1u << r);
+                numRoles++;
+            }
         }
-        
-        // =====================================================
-        // LPG OUTPUT STAGE — Clean and authentic
-        // =====================================================
-        //
-        // In the Buchla 292, the vactrol controls a simple LP filter
-        // and VCA in tandem. There is NO bass boost, no sparkle injection,
-        // no "smile pass" compensation. The bass that survives as the
-        // filter closes does so naturally — because it's below cutoff.
-        //
-        // CRITICAL FIX (v7.2.0): The old "Smile Pass" had a dynamic bass
-        // boost that INCREASED gain as the filter closed, creating a
-        // second amplitude peak 3-5ms after trigger that the ear heard
-        // as a double-hit. Removing it gives monotonic decay = single hit.
-        
-        // Base lowpass output + resonant character from bandpass
-        // The BP mix adds the resonant peak back in — this is where the
-        // "wild" resonance sound lives. Static mix amount per resonance
-        // setting, NOT modulated by gate level (which caused double-hit).
-        float filtered = lp + bp * bpMixAmount;
-        
-        // Apply VCA — this is the ONLY amplitude control
-        float output = filtered * vcaGate;
-        
-        // Apply resonance makeup
-        output *= resMakeupGain;
-        
-        // Blend toward clean bypass at very low resonance
-        if (bypassMix > 0.0f) {
-            float cleanPath = input * vcaGate;
-            output = lerpf(output, cleanPath, bypassMix);
+        uint16_t frames = (uint16_t)numFrames;
+        // Block plus its trailing hash record must fit, or nothing is written
+        if (!reserve(5 + numRoles * numFrames * 4 + 5)) return;
+        uint8_t tag = CAPTURE_BLOCK;
+        put(&tag, 1);
+        put(&frames, 2);
+        put(&mask, 2);
+        for (int r = 0; r < kNumCaptureRoles; r++) {
+            if (buses[r]) put(buses[r], numFrames * 4);
         }
-        
-        // Soft clip to prevent digital overs
-        output = soft_saturate(output, 0.95f);
-        
-        lastBP = bp;
-        return output;
+        hashPending = true;
     }
     
-    float getBandpass() const { return lastBP; }
-    void reset() { s1 = s2 = lastBP = 0.0f; smoothedCutoff = 20.0f; }
-    
-    // Partially dampen filter state on retrigger to prevent energy accumulation
-    // from rapid repeated triggers causing high-pitch blowup
-    void dampStateOnRetrigger() {
-        s1 *= 0.5f;
-        s2 *= 0.5f;
+    // Audio thread - after processing
+    void recordHash(uint32_t hash) {
+        if (!hashPending) return;
+        hashPending = false;
+        uint8_t tag = CAPTURE_HASH;
+        put(&tag, 1);
+        put(&hash, 4);
+        numBlocks++;
     }
     
-private:
-    float sampleRate = 48000.0f;
-    float maxCutoff = 20000.0f;
-    float brightness = 1.0f;
-    float resonance = 0.0f;
-    float k = 2.0f;
-    float resMakeupGain = 1.0f;
-    float bpMixAmount = 0.0f;
-    float s1 = 0.0f, s2 = 0.0f;
-    float smoothedCutoff = 20.0f;
-    float lastBP = 0.0f;
-};
-
-// ============================================================================
-// FX PROCESSOR - Per-effect state, scaled amount curve
-// ============================================================================
-
-class FXProcessor {
-public:
-    void setSampleRate(float sr) {
-        sampleRate = sr;
-        float w = TWO_PI * 720.0f / sr;
-        screamerHPCoef = 1.0f - expf(-w);
-        screamerLPCoef = 1.0f - expf(-w);
-        float gritW = TWO_PI * 4000.0f / sr;
-        gritLPCoef = 1.0f - expf(-gritW);
-    }
+    // End the recording; only start() resumes it
+    void stop() { full = true; }
     
-    void setMode(FXMode mode) { this->mode = mode; }
-    void setAmount(float amt) { amount = clampf(amt, 0.0f, 1.0f); }
+    bool isRecording() const { return !full; }
+    uint32_t getBytesUsed() const { return used; }
+    uint32_t getCapacity() const { return capacity; }
+    uint32_t getNumBlocks() const { return numBlocks; }
+    uint32_t getDroppedEvents() const { return droppedEvents; }
+    const uint8_t* getData() const { return buffer; }
     
-    float process(float input, float bandpass, float gate) {
-        if (mode == FX_CLEAN || amount < 0.01f) {
-            return input;
-        }
-        
-        // Scaled amount curve: <30% subtle, 30-70% transitional, 70%+ full character
-        float scaledAmt;
-        if (amount < 0.3f) {
-            scaledAmt = amount * 0.3f;
-        } else if (amount < 0.7f) {
-            scaledAmt = 0.09f + (amount - 0.3f) * 1.0f;
-        } else {
-            scaledAmt = 0.49f + (amount - 0.7f) * 1.7f;
-        }
-        
-        float wet = input;
-        float makeupGain = 1.0f;
-        
-        switch (mode) {
-            case FX_TUBE:
-                wet = processTube(input, gate, scaledAmt, makeupGain);
-                break;
-            case FX_SCREAMER:
-                wet = processScreamer(input, gate, scaledAmt, makeupGain);
-                break;
-            case FX_GRIT:
-                wet = processGrit(input, bandpass, gate, scaledAmt, makeupGain);
-                break;
-            default:
-                break;
-        }
-        
-        wet *= makeupGain;
-        return lerpf(input, wet, amount);
-    }
+private:
+    static constexpr uint32_t kEventQueueSize = 64;    // Power of two
     
-    void reset() {
-        tubeGridState = 0.0f;
-        tubeDCPrev = 0.0f;
-        tubeDCOut = 0.0f;
-        screamerHP_z = 0.0f;
-        screamerLP_z = 0.0f;
-        gritLP_z = 0.0f;
-        gritHold = 0.0f;
-        gritCounter = 0.0f;
-        gritFeedback = 0.0f;
-    }
+    struct QueuedEvent {
+        uint8_t tag;
+        uint8_t size;
+        uint8_t payload[4];
+    };
     
-private:
-    FXMode mode = FX_CLEAN;
-    float amount = 0.0f;
-    float sampleRate = 48000.0f;
-    
-    // Tube state
-    float tubeGridState = 0.0f;
-    float tubeDCPrev = 0.0f;
-    float tubeDCOut = 0.0f;
-    
-    // Screamer state
-    float screamerHP_z = 0.0f;
-    float screamerLP_z = 0.0f;
-    float screamerHPCoef = 0.1f;
-    float screamerLPCoef = 0.1f;
-    
-    // Grit state
-    float gritLP_z = 0.0f;
-    float gritHold = 0.0f;
-    float gritCounter = 0.0f;
-    float gritFeedback = 0.0f;
-    float gritLPCoef = 0.5f;
-    
-    // TUBE - Rich 12AX7 style saturation with grid blocking
-    float processTube(float x, float gate, float amt, float& makeup) {
-        float drive = 1.5f + amt * 6.0f * (0.5f + gate * 0.5f);
-        x *= drive;
-        
-        // DC offset for asymmetric harmonics (tube character)
-        float dcOffset = amt * 0.18f;
-        x += dcOffset;
-        
-        // Asymmetric soft clipping - positive clips softer (triode character)
-        float out;
-        if (x > 0.0f) {
-            out = x / (1.0f + x * (0.3f + amt * 0.5f));
-        } else {
-            out = x / (1.0f - x * (0.15f + amt * 0.25f));
-        }
-        
-        // Second harmonic (even harmonics = tube warmth)
-        float h2 = x * fabsf(x) * 0.2f * amt;
-        out += h2;
-        
-        // Grid blocking (compression at high levels)
-        if (amt > 0.4f && x > 0.5f) {
-            float excess = x - 0.5f;
-            tubeGridState -= fast_tanh(excess * 3.0f) * 0.0005f * amt;
+    void queueEvent(uint8_t tag, const uint8_t* payload, uint8_t size) {
+        uint32_t next = (eventHead + 1) & (kEventQueueSize - 1);
+        if (next == eventTail) {
+            droppedEvents++;
+            return;
         }
-        tubeGridState *= 0.9998f;
-        out += tubeGridState;
-        
-        // DC blocker
-        float dcBlocked = out - tubeDCPrev + 0.995f * tubeDCOut;
-        tubeDCPrev = out;
-        tubeDCOut = dcBlocked;
-        out = dcBlocked;
-        
-        makeup = 1.4f + amt * 0.4f;
-        return out;
+        QueuedEvent& e = eventQueue[eventHead];
+        e.tag = tag;
+        e.size = size;
+        memcpy(e.payload, payload, size);
+        eventHead = next;
     }
     
-    // SCREAMER - Aggressive Tube Screamer overdrive with bass bypass
-    float processScreamer(float x, float gate, float amt, float& makeup) {
-        float gain = 6.0f + amt * 50.0f;
-        
-        // Highpass - bass bypass
-        float hp = x - screamerHP_z;
-        screamerHP_z += screamerHPCoef * (x - screamerHP_z);
-        
-        // Mix back bass that bypasses the distortion
-        float bassMix = 0.35f + (1.0f - amt) * 0.25f;
-        float gained = hp * gain + x * bassMix;
-        
-        // Hard clip with tanh softening
-        float threshold = 0.5f;
-        float clipped;
-        if (gained > threshold) {
-            clipped = threshold + fast_tanh((gained - threshold) * 2.0f) * 0.4f;
-        } else if (gained < -threshold) {
-            clipped = -threshold + fast_tanh((gained + threshold) * 2.0f) * 0.4f;
-        } else {
-            clipped = gained;
+    bool reserve(uint32_t n) {
+        if (used + n > capacity) {
+            full = true;
+            return false;
         }
-        
-        // Lowpass to smooth
-        screamerLP_z += screamerLPCoef * (clipped - screamerLP_z);
-        float out = screamerLP_z;
-        
-        // Mid boost - the Screamer signature
-        float midBoost = 1.0f + amt * 0.5f;
-        out *= midBoost;
-        
-        makeup = 1.6f + amt * 0.6f;
-        return out;
+        return true;
     }
-    
-    // GRIT - Fuzz + Bit Crush + Sample Rate Reduction with feedback
-    float processGrit(float x, float bp, float gate, float amt, float& makeup) {
-        float dry = x;
-        
-        float fuzzDrive = 2.0f + amt * 15.0f;
-        float fuzzed = x * fuzzDrive;
-        
-        // Rectification for asymmetric harmonics
-        float rectify = amt * 0.3f;
-        fuzzed = fuzzed * (1.0f - rectify) + fabsf(fuzzed) * rectify;
-        
-        // Feedback for self-oscillation character
-        fuzzed -= gritFeedback * amt * 0.4f;
-        
-        // DC bias for asymmetric clipping
-        fuzzed += 0.15f * amt;
-        
-        // Hard asymmetric clipping
-        if (fuzzed > 0.3f) {
-            fuzzed = 0.3f + fast_tanh((fuzzed - 0.3f) * 3.0f) * 0.4f;
-        } else if (fuzzed < -0.5f) {
-            fuzzed = -0.5f + fast_tanh((fuzzed + 0.5f) * 2.0f) * 0.3f;
-        }
-        
-        // Bit crush at higher amounts
-        float crushed = fuzzed;
-        if (amt > 0.3f) {
-            float crushAmt = (amt - 0.3f) / 0.7f;
-            float bits = 10.0f - crushAmt * 7.0f;  // 10-bit down to 3-bit
-            float levels = powf(2.0f, bits);
-            crushed = floorf(fuzzed * levels + 0.5f) / levels;
-            
-            // Sample rate reduction for lo-fi crunch
-            if (amt > 0.5f) {
-                float srReduce = 1.0f + (amt - 0.5f) * 12.0f;
-                gritCounter += 1.0f;
-                if (gritCounter >= srReduce) {
-                    gritCounter -= srReduce;
-                    gritHold = crushed;
-                }
-                crushed = gritHold;
-            }
-        }
-        
-        // Feedback for resonant character
-        float fb = fast_tanh(gritFeedback * amt * 3.0f);
-        crushed -= fb * 0.3f * amt;
-        
-        gritFeedback = crushed;
-        
-        // Light lowpass to tame aliasing
-        gritLP_z += gritLPCoef * (crushed - gritLP_z);
-        float out = gritLP_z;
-        
-        // Keep some dry signal for bass integrity
-        float dryMix = 0.15f * (1.0f - amt * 0.5f);
-        out = out * (1.0f - dryMix) + dry * dryMix;
-        
-        makeup = 1.8f + amt * 0.8f;
-        return out;
+    void put(const void* data, uint32_t n) {
+        memcpy(buffer + used, data, n);
+        used += n;
     }
+    
+    uint8_t* buffer = nullptr;
+    uint32_t capacity = 0;
+    uint32_t used = 0;
+    uint32_t numBlocks = 0;
+    uint32_t droppedEvents = 0;
+    bool full = true;
+    bool hashPending = false;
+    
+    QueuedEvent eventQueue[kEventQueueSize];
+    volatile uint32_t eventHead = 0;
+    volatile uint32_t eventTail = 0;
 };
 
+#else
+#define HM_CAPTURE_DO(x)
+#endif
+
 // ============================================================================
-// DC BLOCKER
+// MIDI NOTE QUEUE - Note-ons from midiMessage(), fired by the next step()
+//
+// The NT hands MIDI over between blocks without a timestamp, so every note
+// that arrived since the last block fires on that block's first sample.
+// Single producer (midiMessage) / single consumer (step), lock-free.
 // ============================================================================
 
-class DCBlocker {
+static constexpr int kMidiChannelOff = 0;
+static constexpr int kMidiChannelOmni = 17;
+static constexpr int kMidiNoteAny = 128;
+
+struct MidiNote {
+    uint8_t note;
+    uint8_t velocity;
+};
+
+class MidiNoteQueue {
 public:
-    float process(float x) {
-        float y = x - xm1 + 0.997f * ym1;
-        xm1 = x;
-        ym1 = y;
-        return y;
+    void reset() { tail = head; }
+    
+    void push(uint8_t note, uint8_t velocity) {
+        uint32_t next = (head + 1) & (kSize - 1);
+        if (next == tail) return;   // A roll faster than one block can hold - oldest win
+        notes[head].note = note;
+        notes[head].velocity = velocity;
+        head = next;
+    }
+    
+    bool pop(MidiNote& out) {
+        if (tail == head) return false;
+        out = notes[tail];
+        tail = (tail + 1) & (kSize - 1);
+        return true;
     }
-    void reset() { xm1 = ym1 = 0.0f; }
+    
 private:
-    float xm1 = 0.0f, ym1 = 0.0f;
+    static constexpr uint32_t kSize = 32;   // Power of two
+    MidiNote notes[kSize];
+    volatile uint32_t head = 0;
+    volatile uint32_t tail = 0;
 };
 
 // ============================================================================
-// TRIGGER DETECTOR - Schmitt trigger with hysteresis + rearm guard
-//
-// CRITICAL FIX (v7.2.0): The old detector used a single threshold with
-// only 5ms lockout. Noisy Eurorack triggers would fire twice:
-//   1. Rising edge crosses threshold → trigger #1, lockout starts
-//   2. Signal wobbles below threshold during pulse
-//   3. After 5ms lockout: signal still high, or noise re-crosses → trigger #2
+// LOAD GOVERNOR - Drops the quality tier when step() eats its CPU budget
 //
-// Fix: Schmitt trigger (separate high/low thresholds) + must see N
-// consecutive low samples before re-arming + 15ms lockout.
+// Load is the time step() took as a fraction of the block's real-time
+// deadline (two timer reads per block). Sustained load over the budget
+// drops one tier; a long stretch well under it restores one. A restore
+// that is quickly undone doubles the wait before the next attempt, so a
+// patch sitting right at the edge settles instead of toggling.
 // ============================================================================
 
-class TriggerDetector {
+class LoadGovernor {
 public:
-    void setSampleRate(float sr) { sampleRate = sr; }
-    void setThreshold(float v) { 
-        thresholdHigh = clampf(v, 0.01f, 5.0f);
-        // Hysteresis: must drop to 70% of threshold before re-arming
-        thresholdLow = thresholdHigh * 0.7f;
+    void reset() {
+        cap = QUALITY_HQ;
+        overSeconds = underSeconds = sinceRestore = 0.0f;
+        restoreWait = kRestoreMinSeconds;
+        restored = false;
+        load = 0.0f;
     }
     
-    bool process(float input) {
-        if (lockoutSamples > 0) {
-            lockoutSamples--;
-        }
-        
-        // Schmitt trigger logic:
-        // - To fire: input must cross thresholdHigh while armed
-        // - To re-arm: input must drop below thresholdLow for minLowSamples
-        bool aboveHigh = input > thresholdHigh;
-        bool belowLow = input < thresholdLow;
-        
-        // Track consecutive samples below low threshold for re-arm
-        if (belowLow) {
-            lowCount++;
+    // Tier to run with: the user's choice, or lower if the governor says so
+    QualityTier getTier(QualityTier user) const { return cap < user ? cap : user; }
+    bool isLimiting(QualityTier user) const { return cap < user; }
+    float getLoad() const { return load; }
+    
+    void update(float blockLoad, float budget, float blockSeconds, QualityTier user) {
+        load = blockLoad;
+        if (cap > user) cap = user;
+        if (restored) sinceRestore += blockSeconds;
+        
+        if (blockLoad > budget) {
+            underSeconds = 0.0f;
+            overSeconds += blockSeconds;
+            if (overSeconds >= kDropSeconds && cap > QUALITY_ECO) {
+                if (restored && sinceRestore < restoreWait) {
+                    restoreWait = fminf(restoreWait * 2.0f, kRestoreMaxSeconds);
+                }
+                cap = (QualityTier)(cap - 1);
+                overSeconds = 0.0f;
+                restored = false;
+            }
         } else {
-            lowCount = 0;
-        }
-        
-        // Re-arm only after signal has been convincingly low
-        if (!armed && lowCount >= minLowSamples) {
-            armed = true;
+            overSeconds = 0.0f;
+            if (blockLoad < budget * kRestoreRatio && cap < user) {
+                underSeconds += blockSeconds;
+                if (underSeconds >= restoreWait) {
+                    cap = (QualityTier)(cap + 1);
+                    underSeconds = 0.0f;
+                    sinceRestore = 0.0f;
+                    restored = true;
+                }
+            } else {
+                underSeconds = 0.0f;
+            }
         }
         
-        // Fire on rising edge above high threshold, if armed and not locked out
-        bool trig = aboveHigh && armed && (lockoutSamples == 0);
-        
-        if (trig) {
-            lastLevel = input;
-            armed = false;  // Must re-arm before next trigger
-            lowCount = 0;
-            lockoutSamples = (int)(sampleRate * 0.015f);  // 15ms lockout
+        // A restore that held for the full backoff window was the right call
+        if (restored && sinceRestore >= kRestoreMaxSeconds) {
+            restored = false;
+            restoreWait = kRestoreMinSeconds;
         }
-        
-        return trig;
-    }
-    
-    float getLastLevel() const { return lastLevel; }
-    void reset() { 
-        armed = true; 
-        lastLevel = 0.0f; 
-        lockoutSamples = 0; 
-        lowCount = 0; 
     }
     
 private:
-    float sampleRate = 48000.0f;
-    float thresholdHigh = 0.1f;
-    float thresholdLow = 0.07f;
-    bool armed = true;
-    float lastLevel = 0.0f;
-    int lockoutSamples = 0;
-    int lowCount = 0;
-    static constexpr int minLowSamples = 16;  // ~0.33ms at 48kHz — must be low this long to re-arm
+    static constexpr float kDropSeconds = 0.01f;        // Sustained overload before dropping
+    static constexpr float kRestoreRatio = 0.6f;        // "Well under budget"
+    static constexpr float kRestoreMinSeconds = 0.5f;
+    static constexpr float kRestoreMaxSeconds = 8.0f;
+    
+    QualityTier cap = QUALITY_HQ;
+    float overSeconds = 0.0f;
+    float underSeconds = 0.0f;
+    float sinceRestore = 0.0f;
+    float restoreWait = kRestoreMinSeconds;
+    bool restored = false;
+    float load = 0.0f;
 };
 
 // ============================================================================
-// LPG CHANNEL - Single vactrol model with level-dependent decay
+// PARAMETER SNAPSHOTS - parameterChanged() publishes, step() adopts per block
 //
-// Based on Parker & D'Angelo, DAFX-13:
-// One continuous curve from the vactrol's photoresistive element.
-// Filter and VCA derive from nonlinear transfer functions of
-// the single vactrol state, not separate envelopes.
+// Everything step() needs from the parameter array, decoded once on the
+// control path into a compact struct. Two slots and a sequence counter
+// (a seqlock): the writer fills the slot the newest snapshot is not in,
+// then publishes its number. The reader copies the newest slot and
+// checks no later write started on it meanwhile; if one did, it keeps
+// what it has and picks the fresh one up next block. Neither side waits,
+// and a block never runs on a half-updated parameter set.
 // ============================================================================
 
-class LPGChannel {
+struct ParamSnapshot {
+    // Channel
+    float resonance;
+    float decay;
+    float open;
+    float dampening;
+    float fxAmount;
+    float gain;
+    MaterialMode material;
+    FXMode fxMode;
+    bool hitMemory;
+    
+    // Body
+    bool bodyOn;
+    float bodyTune;
+    float bodyMix;
+    
+    // Triggering
+    TriggerSource triggerSource;
+    float triggerThreshold;     // Volts
+    int triggerBus;             // 0 = none
+    int midiNoteL;
+    int midiNoteR;
+    
+    // Routing: bus numbers, 0 = none
+    int leftInput;
+    int rightInput;
+    int leftOutput;
+    int rightOutput;
+    int envOutput;
+    int highpassOutput;
+    int bandpassOutput;
+    int filterGateOutput;
+    int vcaGateOutput;
+    bool leftReplace;
+    bool rightReplace;
+    bool highpassReplace;
+    bool bandpassReplace;
+    bool filterGateReplace;
+    bool vcaGateReplace;
+    bool stereo;
+    bool envFollower;
+    int resonanceCV;
+    int decayCV;
+    int openCV;
+    int dampeningCV;
+    int fxAmountCV;
+    
+    // Quality
+    QualityTier quality;
+    bool governor;
+    float governorBudget;
+    bool hitCache;
+};
+
+class ParamSnapshotExchange {
 public:
-    void setSampleRate(float sr) {
-        sampleRate = sr;
-        filter.setSampleRate(sr);
-        fx.setSampleRate(sr);
-    }
-    
-    void setParams(float resonance, float decayParam, float openParam, float dampening,
-                   MaterialMode material, FXMode fxMode, float fxAmount, float inputGain,
-                   bool hitMemory) {
-        this->baseOpenCeiling = openParam;
-        this->openCeiling = openParam;
-        this->dampening = dampening;
-        this->material = material;
-        this->inputGain = inputGain;
-        this->hitMemoryOn = hitMemory;
-        this->baseDecayParam = decayParam;
-        
-        updateDecayFromParam(decayParam);
-        
-        // Dampening = hand on drum / towel on cymbal
-        // Reduces brightness MORE aggressively (mutes upper harmonics)
-        // Also slightly reduces resonance (dampened objects don't ring)
-        float dampeningBrightness = 1.0f - dampening * 0.85f;  // At 100%: 15% brightness
-        float dampeningResCut = 1.0f - dampening * 0.4f;       // At 100%: 60% resonance
-        
-        filter.setResonance(resonance * dampeningResCut);
-        filter.setBrightness(kMaterialBrightness[material] * dampeningBrightness);
-        
-        fx.setMode(fxMode);
-        fx.setAmount(fxAmount);
-    }
-    
-    // Fast CV update - only updates targets, no expensive calculations
-    void updateCV(float decayMod, float openMod) {
-        openCeiling = clampf(baseOpenCeiling + openMod, 0.0f, 1.0f);
-        float modDecay = clampf(baseDecayParam + decayMod, 0.0f, 1.0f);
-        updateDecayFromParam(modDecay);
-    }
-    
-    void trigger(float velocity = 1.0f) {
-        float targetLevel = velocity * openCeiling;
-        
-        if (hitMemoryOn) {
-            float previousState = vactrolState;
-            targetLevel = clampf(vactrolState + targetLevel, 0.0f, 1.2f);
-            
-            // Warm vactrol effect: accumulated energy means the vactrol
-            // stays open longer. Scale decay slowdown by how much state
-            // we're building on. At full accumulation, decay slows ~40%.
-            float warmth = clampf(previousState * 0.4f, 0.0f, 0.4f);
-            memoryDecayScale = 1.0f + warmth;  // 1.0 = no effect, 1.4 = 40% slower
-        } else {
-            memoryDecayScale = 1.0f;
-        }
-        
-        // SINGLE VACTROL MODEL — The vactrol IS the envelope.
-        //
-        // In the real Buchla 292, CV hits the LED, which instantly illuminates
-        // the photoresistor. The "click" is the gate snapping open.
-        // There is NO separate filter envelope and VCA envelope.
-        // One resistance (Rf) controls everything.
-        //
-        // The vactrol state then decays via level-dependent continuous curve
-        // (modeled in process()). The "filter closes before VCA" behavior
-        // comes from nonlinear transfer functions, not separate envelopes.
-        vactrolState = targetLevel;
-        
-        triggerVelocity = velocity;
-        triggerVisual = 1.0f;
-        
-        // Dampen filter state on retrigger to prevent energy accumulation
-        filter.dampStateOnRetrigger();
+    void reset() {
+        started = published = adopted = 0;
     }
     
-    float process(float input) {
-        // =====================================================
-        // SINGLE VACTROL ENVELOPE — LEVEL-DEPENDENT DECAY
-        // =====================================================
-        //
-        // Based on Parker & D'Angelo, DAFX-13:
-        // The vactrol's photoresistive element has a continuous decay
-        // where higher illumination (higher state) decays faster due to
-        // greater carrier recombination rate. This naturally produces
-        // the "thwack → body" contour that the old two-stage approach
-        // tried to achieve with a hard boundary and crossfade.
-        //
-        // The key: ONE continuous curve, NO stage boundaries.
-        //   High level → fast decay (the initial transient/thwack)
-        //   Low level → slow decay (the lingering body/tail)
-        //
-        // vactrolDecayMod controls the strength of this effect:
-        //   0 = pure exponential (electronic, uniform decay)
-        //   2+ = strong level-dependence (struck/plucked character)
-        
-        if (vactrolState > 0.0f) {
-            // Level-dependent speed: faster at high levels, slower at low
-            // The squared term gives us a continuous curve that gracefully transitions
-            // from "thwack" speed to "body" speed — no stages, no crossfade
-            float speedFactor = 1.0f + vactrolState * vactrolState * vactrolDecayMod;
-            
-            // Velocity shapes the initial speed — harder hits decay faster initially
-            // (more energy in = faster initial dissipation, like a real struck object)
-            float velShape = 1.0f + (triggerVelocity - 0.5f) * 0.3f * vactrolState;
-            
-            // OPTIMIZATION: Combine both power operations into single expf
-            // powf(coef, speed) = expf(speed * logf(coef))
-            // powf(result, velShape) = expf(velShape * speed * logf(coef))
-            // Combined: expf(speedFactor * velShape * logBaseDecayCoef)
-            // This replaces 2x powf (~200 cycles each) with 1x expf (~60 cycles)
-            float totalPower = speedFactor * velShape;
-            
-            // Hit memory warmth: divide totalPower to slow decay
-            // (higher memoryDecayScale = slower effective decay)
-            totalPower /= memoryDecayScale;
-            
-            float effectiveCoef = expf(totalPower * logBaseDecayCoef);
-            
-            vactrolState *= effectiveCoef;
-            
-            // Denormal clamp
-            if (vactrolState < 0.0001f) vactrolState = 0.0f;
-        }
-        
-        // =====================================================
-        // NONLINEAR TRANSFER: SINGLE STATE → FILTER + VCA
-        // =====================================================
-        //
-        // In the real Buchla 292, one Rf controls both:
-        //   - Filter cutoff: ∝ 1/Rf (drops early as Rf increases)
-        //   - VCA gain: Rα/(Rα + 2Rf) (stays open longer, drops late)
-        //
-        // We model this with transfer curves:
-        //   filterGate = pow(vactrolState, filterExponent)  — drops fast
-        //   vcaGate = sqrt(vactrolState) or similar         — holds open
-        //
-        // The filterExponent is material-dependent, encoding the "pluck"
-        // character that the old dual-envelope tried to create with
-        // separate decay rates. Now it comes from curve shape instead.
-        
-        float filterGate = powf(vactrolState, filterExponent);
-        float vcaGate = sqrtf(fmaxf(vactrolState, 0.0f));
-        
-        // Dampening: reduce VCA ceiling (hand absorbs energy, doesn't speed it up)
-        // At 100% dampening: output is 25% of normal — heavily muted but same decay shape
-        float dampeningVCA = 1.0f - dampening * 0.75f;
-        vcaGate *= dampeningVCA;
-        
-        // At very low levels, ensure clean zero-crossing
-        if (vcaGate < 0.001f) vcaGate = 0.0f;
-        if (filterGate < 0.001f) filterGate = 0.0f;
-        
-        lastGate = vcaGate;
-        
-        input *= inputGain;
-        
-        float filtered = filter.process(input, filterGate, vcaGate);
-        
-        float bp = filter.getBandpass();
-        float processed = fx.process(filtered, bp, vcaGate);
-        
-        processed = dcBlocker.process(processed);
-        
-        // Final safety limiter
-        processed = soft_saturate(processed, 0.98f);
-        
-        // NaN/inf protection - last line of defense against lockup
-        if (!(processed == processed) || processed > 10.0f || processed < -10.0f) {
-            processed = 0.0f;
-            filter.reset();
-            dcBlocker.reset();
-        }
-        
-        triggerVisual *= 0.96f;
-        
-        return processed;
+    // Control path - O(1), never blocks
+    void publish(const ParamSnapshot& s) {
+        uint32_t seq = started + 1;
+        __atomic_store_n(&started, seq, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        slots[seq & 1] = s;
+        __atomic_store_n(&published, seq, __ATOMIC_RELEASE);
     }
     
-    float getGateValue() const { return lastGate; }
-    float getTriggerVisual() const { return triggerVisual; }
-    
-    void reset() {
-        filter.reset();
-        fx.reset();
-        dcBlocker.reset();
-        vactrolState = 0.0f;
-        triggerVisual = 0.0f;
-        lastGate = 0.0f;
+    // Audio path: copies the newest complete snapshot into `out` if there
+    // is one it hasn't adopted yet
+    bool adopt(ParamSnapshot& out) {
+        uint32_t seq = __atomic_load_n(&published, __ATOMIC_ACQUIRE);
+        if (seq == adopted) return false;
+        ParamSnapshot copy = slots[seq & 1];
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        // A write two snapshots on reuses this slot - the copy may be torn
+        if (__atomic_load_n(&started, __ATOMIC_RELAXED) - seq >= 2) return false;
+        out = copy;
+        adopted = seq;
+        return true;
     }
     
 private:
-    void updateDecayFromParam(float decayParam) {
-        // Non-linear scaling for musical response
-        // Maps 0-1 parameter to decay time in milliseconds
-        float baseDecayMs;
-        if (decayParam < 0.05f) {
-            float t = decayParam / 0.05f;
-            baseDecayMs = 5.0f + t * 10.0f;
-        } else if (decayParam < 0.15f) {
-            float t = (decayParam - 0.05f) / 0.10f;
-            baseDecayMs = 15.0f + t * 25.0f;
-        } else if (decayParam < 0.30f) {
-            float t = (decayParam - 0.15f) / 0.15f;
-            baseDecayMs = 40.0f + t * 60.0f;
-        } else if (decayParam < 0.50f) {
-            float t = (decayParam - 0.30f) / 0.20f;
-            baseDecayMs = 100.0f + t * 100.0f;
-        } else if (decayParam < 0.70f) {
-            float t = (decayParam - 0.50f) / 0.20f;
-            baseDecayMs = 200.0f + t * 300.0f;
-        } else if (decayParam < 0.85f) {
-            float t = (decayParam - 0.70f) / 0.15f;
-            baseDecayMs = 500.0f + t * 1000.0f;
-        } else {
-            float t = (decayParam - 0.85f) / 0.15f;
-            baseDecayMs = 1500.0f + t * 3500.0f;
-        }
-        
-        float vcaDecayMs = baseDecayMs * kMaterialDecayMult[material];
-        // NOTE: dampening does NOT affect decay time.
-        // Dampening = hand on drum: reduces brightness + output level.
-        // It's applied in setParams() (brightness) and process() (VCA ceiling).
-        // A dampened drum rings just as long — you just hear less of it.
-        
-        // SINGLE VACTROL DECAY MODEL
-        // One coefficient, one continuous curve. The level-dependent
-        // speed modulation in process() creates the thwack/body contour.
-        float bodySamples = vcaDecayMs * 1.5f * 0.001f * sampleRate;
-        
-        if (bodySamples > 0.0f) {
-            baseDecayCoefficient = expf(-6.9078f / bodySamples);
-            // Pre-compute log for efficient per-sample powf replacement:
-            // powf(coef, speed) = expf(speed * logf(coef))
-            // This saves a logf() call every sample on Cortex-M7
-            logBaseDecayCoef = logf(baseDecayCoefficient);
-        } else {
-            baseDecayCoefficient = 0.0f;
-            logBaseDecayCoef = -100.0f; // large negative → instant decay
-        }
-        
-        // Vactrol level-dependent modulation from material
-        vactrolDecayMod = kMaterialVactrolMod[material];
-        
-        // Filter transfer exponent from material
-        filterExponent = kMaterialFilterExponent[material];
-    }
-    
-    float sampleRate = 48000.0f;
-    float openCeiling = 1.0f;
-    float baseOpenCeiling = 1.0f;
-    float dampening = 0.0f;
-    float inputGain = 1.0f;
-    float baseDecayParam = 0.5f;
-    MaterialMode material = MATERIAL_NATURAL;
-    bool hitMemoryOn = false;
-    
-    float vactrolState = 0.0f;      // Single vactrol photoresistive state (0=dark, 1=bright)
-    float triggerVelocity = 1.0f;
-    float memoryDecayScale = 1.0f;   // Hit memory warmth: >1 = slower decay from accumulated energy
-    
-    // Single vactrol decay model
-    float baseDecayCoefficient = 0.999f;    // Base decay rate (body/tail speed)
-    float logBaseDecayCoef = -0.001f;       // Pre-computed logf(baseDecayCoef) for Cortex-M7 optimization
-    float vactrolDecayMod = 2.5f;           // Level-dependent speed modulation
-    float filterExponent = 1.8f;            // Nonlinear filter transfer curve
-    
-    float triggerVisual = 0.0f;
-    float lastGate = 0.0f;
-    
-    BuchlaLPGFilter filter;
-    FXProcessor fx;
-    DCBlocker dcBlocker;
+    ParamSnapshot slots[2];
+    uint32_t started = 0;       // Last sequence number a write began on
+    uint32_t published = 0;     // Last sequence number fully written
+    uint32_t adopted = 0;       // Reader-side: last one taken
 };
 
+// Static DRAM for the hit cache, shared by every channel of every
+// instance: 8 slots of 4096 frames (~85ms of envelope head each at 48kHz).
+// A curve is a pure function of its key, so layers striking alike replay
+// each other's. Reserved whether or not any instance turns the cache on;
+// the replayed share of each curve scales with it (README, Hit Cache), so
+// a smaller build trades replay for memory. HM_HIT_CACHE_BYTES=0 leaves it
+// out.
+#ifndef HM_HIT_CACHE_BYTES
+#define HM_HIT_CACHE_BYTES (256u << 10)
+#endif
+
+// Static DRAM, set up by initialise(); null on a host that never calls it
+static HitCache* sharedHitCache = nullptr;
+
 // ============================================================================
 // MAIN ALGORITHM
 // ============================================================================
@@ -971,13 +575,38 @@ struct _holyMackerelAlgorithm : public _NT_algorithm {
     ~_holyMackerelAlgorithm() {}
     
     float sampleRate;
+    int controlFrames;      // Samples per control block (kControlRateHz)
     
     LPGChannel channelL;
     LPGChannel channelR;
-    TriggerDetector trigger;
+    StrikeDetector strike;
+    MidiNoteQueue midiNotes;
+    
+    // Parameters the DSP is running on; replaced between blocks only
+    ParamSnapshot params;
+    ParamSnapshotExchange paramExchange;
     
     float hitIntensity;
     float hitPhase;
+    
+    // Tier the channels are currently running, after the governor
+    QualityTier activeTier;
+    LoadGovernor governor;
+    
+    // Run time since construct, for the health page
+    uint32_t runFrames;
+    uint32_t runSeconds;
+    
+#if HM_PROFILE
+    StageProfiler profiler;
+#endif
+#if HM_TRACE
+    StateTrace trace;
+#endif
+#if HM_CAPTURE
+    BusCapture capture;
+    volatile bool captureRestart;
+#endif
 };
 
 // ============================================================================
@@ -1013,13 +642,54 @@ enum {
     kParamEnvFollower,
     kParamEnvOutput,
     
+    kParamDisplay,
+    
+    kParamQuality,
+    kParamGovernor,
+    kParamGovernorBudget,
+    
+    kParamMidiChannel,
+    kParamMidiNoteL,
+    kParamMidiNoteR,
+    
+    kParamTriggerSource,
+    
+    kParamBody,
+    kParamBodyTune,
+    kParamBodyMix,
+    
+    kParamHighpassOutput,
+    kParamHighpassOutputMode,
+    kParamBandpassOutput,
+    kParamBandpassOutputMode,
+    kParamFilterGateOutput,
+    kParamFilterGateOutputMode,
+    kParamVCAGateOutput,
+    kParamVCAGateOutputMode,
+    kParamHitCache,
+    
     kNumParams
 };
 
+enum DisplayPage {
+    DISPLAY_GATE = 0,
+    DISPLAY_CPU = 1,
+    DISPLAY_HEALTH = 2,
+    DISPLAY_TRACE = 3,
+    DISPLAY_CAPTURE = 4
+};
+
 static const char* const materialStrings[] = { "Natural", "Hard", "Soft", nullptr };
 static const char* const fxStrings[] = { "Clean", "Tube", "Screamer", "Grit", nullptr };
 static const char* const stereoStrings[] = { "Mono", "Stereo", nullptr };
 static const char* const onOffStrings[] = { "Off", "On", nullptr };
+static const char* const displayStrings[] = { "Gate", "CPU", "Health", "Trace", "Capture", nullptr };
+static const char* const qualityStrings[] = { "Eco", "Standard", "HQ", nullptr };
+static const char* const trigSourceStrings[] = { "Bus", "Audio", "CV", nullptr };
+static const char* const midiChannelStrings[] = {
+    "Off", "1", "2", "3", "4", "5", "6", "7", "8",
+    "9", "10", "11", "12", "13", "14", "15", "16", "Omni", nullptr
+};
 
 static const _NT_parameter parameters[] = {
     // Page 1: Holy Mackerel
@@ -1050,16 +720,48 @@ static const _NT_parameter parameters[] = {
     NT_PARAMETER_AUDIO_OUTPUT_WITH_MODE( "Right Output", 1, 14 )
     { .name = "Env Follower",   .min = 0,  .max = 1,   .def = 0,   .unit = kNT_unitEnum,       .scaling = kNT_scalingNone, .enumStrings = onOffStrings },
     NT_PARAMETER_CV_OUTPUT( "Env Output", 0, 0 )
+    
+    // Page 5: Diagnostics
+    { .name = "Display",        .min = 0,  .max = 4,   .def = 0,   .unit = kNT_unitEnum,       .scaling = kNT_scalingNone, .enumStrings = displayStrings },
+    
+    // Page 4: Performance
+    { .name = "Quality",        .min = 0,  .max = 2,   .def = 1,   .unit = kNT_unitEnum,       .scaling = kNT_scalingNone, .enumStrings = qualityStrings },
+    { .name = "Governor",       .min = 0,  .max = 1,   .def = 0,   .unit = kNT_unitEnum,       .scaling = kNT_scalingNone, .enumStrings = onOffStrings },
+    { .name = "CPU Budget",     .min = 5,  .max = 100, .def = 25,  .unit = kNT_unitPercent,    .scaling = kNT_scalingNone, .enumStrings = NULL },
+    
+    // Page 3: Routing (MIDI trigger source)
+    { .name = "MIDI Channel",   .min = 0,  .max = 17,  .def = 0,   .unit = kNT_unitEnum,       .scaling = kNT_scalingNone, .enumStrings = midiChannelStrings },
+    { .name = "MIDI Note L",    .min = 0,  .max = 128, .def = 128, .unit = kNT_unitNone,       .scaling = kNT_scalingNone, .enumStrings = NULL },   // 128 = any note
+    { .name = "MIDI Note R",    .min = 0,  .max = 128, .def = 128, .unit = kNT_unitNone,       .scaling = kNT_scalingNone, .enumStrings = NULL },
+    { .name = "Trig Source",    .min = 0,  .max = 2,   .def = 0,   .unit = kNT_unitEnum,       .scaling = kNT_scalingNone, .enumStrings = trigSourceStrings },
+    
+    // Page 1: Holy Mackerel (modal body)
+    { .name = "Body",        .min = 0,  .max = 1,   .def = 0,   .unit = kNT_unitEnum,        .scaling = kNT_scalingNone, .enumStrings = onOffStrings },
+    { .name = "Body Tune",   .min = -24, .max = 24, .def = 0,   .unit = kNT_unitSemitones,   .scaling = kNT_scalingNone, .enumStrings = NULL },
+    { .name = "Body Mix",    .min = 0,  .max = 100, .def = 50,  .unit = kNT_unitPercent,     .scaling = kNT_scalingNone, .enumStrings = NULL },
+    
+    // Page 3: Routing (filter taps and gates, left channel)
+    NT_PARAMETER_AUDIO_OUTPUT_WITH_MODE( "HP Output", 0, 0 )
+    NT_PARAMETER_AUDIO_OUTPUT_WITH_MODE( "BP Output", 0, 0 )
+    NT_PARAMETER_CV_OUTPUT_WITH_MODE( "Filter Gate Out", 0, 0 )
+    NT_PARAMETER_CV_OUTPUT_WITH_MODE( "VCA Gate Out", 0, 0 )
+    
+    // Page 4: Performance (hit cache)
+    { .name = "Hit Cache",      .min = 0,  .max = 1,   .def = 0,   .unit = kNT_unitEnum,       .scaling = kNT_scalingNone, .enumStrings = onOffStrings },
 };
 
-static const uint8_t page1[] = { kParamResonance, kParamDecay, kParamOpen, kParamDampening, kParamMaterial, kParamFX, kParamFXAmount, kParamGain, kParamHitMemory };
+static const uint8_t page1[] = { kParamResonance, kParamDecay, kParamOpen, kParamDampening, kParamMaterial, kParamFX, kParamFXAmount, kParamGain, kParamHitMemory, kParamBody, kParamBodyTune, kParamBodyMix };
 static const uint8_t page2[] = { kParamResonanceCV, kParamDecayCV, kParamOpenCV, kParamDampeningCV, kParamFXAmountCV };
-static const uint8_t page3[] = { kParamTriggerInput, kParamTriggerThreshold, kParamStereo, kParamLeftInput, kParamRightInput, kParamLeftOutput, kParamLeftOutputMode, kParamRightOutput, kParamRightOutputMode, kParamEnvFollower, kParamEnvOutput };
+static const uint8_t page3[] = { kParamTriggerSource, kParamTriggerInput, kParamTriggerThreshold, kParamMidiChannel, kParamMidiNoteL, kParamMidiNoteR, kParamStereo, kParamLeftInput, kParamRightInput, kParamLeftOutput, kParamLeftOutputMode, kParamRightOutput, kParamRightOutputMode, kParamEnvFollower, kParamEnvOutput, kParamHighpassOutput, kParamHighpassOutputMode, kParamBandpassOutput, kParamBandpassOutputMode, kParamFilterGateOutput, kParamFilterGateOutputMode, kParamVCAGateOutput, kParamVCAGateOutputMode };
+static const uint8_t page4[] = { kParamQuality, kParamGovernor, kParamGovernorBudget, kParamHitCache };
+static const uint8_t page5[] = { kParamDisplay };
 
 static const _NT_parameterPage pages[] = {
     { .name = "Holy Mackerel", .numParams = ARRAY_SIZE(page1), .params = page1 },
     { .name = "CV Control",    .numParams = ARRAY_SIZE(page2), .params = page2 },
     { .name = "Routing",       .numParams = ARRAY_SIZE(page3), .params = page3 },
+    { .name = "Performance",   .numParams = ARRAY_SIZE(page4), .params = page4 },
+    { .name = "Diagnostics",   .numParams = ARRAY_SIZE(page5), .params = page5 },
 };
 
 static const _NT_parameterPages parameterPages = {
@@ -1080,6 +782,102 @@ static inline float getGainFromParam(int g) {
     }
 }
 
+// Decodes the parameter array for step() - plain loads and scales only
+static void readParamSnapshot(const int16_t* v, ParamSnapshot& s) {
+    s.resonance = v[kParamResonance] / 100.0f;
+    s.decay = v[kParamDecay] / 100.0f;
+    s.open = v[kParamOpen] / 100.0f;
+    s.dampening = v[kParamDampening] / 100.0f;
+    s.fxAmount = v[kParamFXAmount] / 100.0f;
+    s.gain = getGainFromParam(v[kParamGain]);
+    s.material = (MaterialMode)v[kParamMaterial];
+    s.fxMode = (FXMode)v[kParamFX];
+    s.hitMemory = (v[kParamHitMemory] == 1);
+    
+    s.bodyOn = (v[kParamBody] == 1);
+    s.bodyTune = (float)v[kParamBodyTune];
+    s.bodyMix = v[kParamBodyMix] / 100.0f;
+    
+    s.triggerSource = (TriggerSource)v[kParamTriggerSource];
+    s.triggerThreshold = v[kParamTriggerThreshold] / 1000.0f;    // Millivolts → volts
+    s.triggerBus = v[kParamTriggerInput];
+    s.midiNoteL = v[kParamMidiNoteL];
+    s.midiNoteR = v[kParamMidiNoteR];
+    
+    s.leftInput = v[kParamLeftInput];
+    s.rightInput = v[kParamRightInput];
+    s.leftOutput = v[kParamLeftOutput];
+    s.rightOutput = v[kParamRightOutput];
+    s.envOutput = v[kParamEnvOutput];
+    s.highpassOutput = v[kParamHighpassOutput];
+    s.bandpassOutput = v[kParamBandpassOutput];
+    s.filterGateOutput = v[kParamFilterGateOutput];
+    s.vcaGateOutput = v[kParamVCAGateOutput];
+    s.leftReplace = (v[kParamLeftOutputMode] != 0);
+    s.rightReplace = (v[kParamRightOutputMode] != 0);
+    s.highpassReplace = (v[kParamHighpassOutputMode] != 0);
+    s.bandpassReplace = (v[kParamBandpassOutputMode] != 0);
+    s.filterGateReplace = (v[kParamFilterGateOutputMode] != 0);
+    s.vcaGateReplace = (v[kParamVCAGateOutputMode] != 0);
+    s.stereo = (v[kParamStereo] == 1);
+    s.envFollower = (v[kParamEnvFollower] == 1);
+    s.resonanceCV = v[kParamResonanceCV];
+    s.decayCV = v[kParamDecayCV];
+    s.openCV = v[kParamOpenCV];
+    s.dampeningCV = v[kParamDampeningCV];
+    s.fxAmountCV = v[kParamFXAmountCV];
+    
+    s.quality = (QualityTier)v[kParamQuality];
+    s.governor = (v[kParamGovernor] == 1);
+    s.governorBudget = v[kParamGovernorBudget] / 100.0f;
+    s.hitCache = (v[kParamHitCache] == 1);
+}
+
+// Brings the DSP in line with a snapshot, recomputing coefficients only
+// for what changed. Runs on the audio thread, between blocks (and once
+// from construct(), forced, before there is anything to compare with).
+static void applyParamSnapshot(_holyMackerelAlgorithm* alg, const ParamSnapshot& next, bool force) {
+    const ParamSnapshot& prev = alg->params;
+    
+    bool channelChanged = force ||
+        next.resonance != prev.resonance || next.decay != prev.decay ||
+        next.open != prev.open || next.dampening != prev.dampening ||
+        next.fxAmount != prev.fxAmount || next.gain != prev.gain ||
+        next.material != prev.material || next.fxMode != prev.fxMode ||
+        next.hitMemory != prev.hitMemory;
+    if (channelChanged) {
+        alg->channelL.setParams(next.resonance, next.decay, next.open, next.dampening, next.material,
+                                next.fxMode, next.fxAmount, next.gain, next.hitMemory);
+        alg->channelR.setParams(next.resonance, next.decay, next.open, next.dampening, next.material,
+                                next.fxMode, next.fxAmount, next.gain, next.hitMemory);
+    }
+    
+    if (force || next.bodyOn != prev.bodyOn || next.bodyTune != prev.bodyTune || next.bodyMix != prev.bodyMix) {
+        alg->channelL.setBody(next.bodyOn, next.bodyTune, next.bodyMix);
+        alg->channelR.setBody(next.bodyOn, next.bodyTune, next.bodyMix);
+    }
+    
+    if (force || next.triggerThreshold != prev.triggerThreshold) {
+        alg->strike.setThreshold(next.triggerThreshold);
+    }
+    if (force || next.triggerSource != prev.triggerSource) {
+        alg->strike.setSource(next.triggerSource);
+        alg->channelL.setCVMode(next.triggerSource == TRIG_SOURCE_CV);
+        alg->channelR.setCVMode(next.triggerSource == TRIG_SOURCE_CV);
+    }
+    
+    if (force || next.hitCache != prev.hitCache) {
+        HitCache* cache = next.hitCache ? sharedHitCache : nullptr;
+        alg->channelL.setHitCache(cache);
+        alg->channelR.setHitCache(cache);
+    }
+    
+    // Switching the governor on starts it from a clean slate
+    if (next.governor && !prev.governor && !force) alg->governor.reset();
+    
+    alg->params = next;
+}
+
 // ============================================================================
 // GREYING LOGIC - Hide irrelevant parameters contextually
 // ============================================================================
@@ -1090,28 +888,73 @@ void updateGrayed(_holyMackerelAlgorithm* alg) {
     bool mono = (alg->v[kParamStereo] == 0);
     bool clean = (alg->v[kParamFX] == FX_CLEAN);
     bool envOff = (alg->v[kParamEnvFollower] == 0);
+    bool governorOff = (alg->v[kParamGovernor] == 0);
+    bool midiOff = (alg->v[kParamMidiChannel] == kMidiChannelOff);
+    bool audioTrigger = (alg->v[kParamTriggerSource] == TRIG_SOURCE_AUDIO);
+    bool cvGate = (alg->v[kParamTriggerSource] == TRIG_SOURCE_CV);
+    bool bodyOff = (alg->v[kParamBody] == 0);
     
     // Grey Right I/O when in mono mode
     NT_setParameterGrayedOut(idx, kParamRightInput + off, mono);
     NT_setParameterGrayedOut(idx, kParamRightOutput + off, mono);
     NT_setParameterGrayedOut(idx, kParamRightOutputMode + off, mono);
     
+    // Grey the trigger bus when triggering from the audio input, and the
+    // threshold when the bus is a CV rather than a trigger
+    NT_setParameterGrayedOut(idx, kParamTriggerInput + off, audioTrigger);
+    NT_setParameterGrayedOut(idx, kParamTriggerThreshold + off, cvGate);
+    
+    // Grey the note map when MIDI is off (and the right note in mono)
+    NT_setParameterGrayedOut(idx, kParamMidiNoteL + off, midiOff);
+    NT_setParameterGrayedOut(idx, kParamMidiNoteR + off, midiOff || mono);
+    
     // Grey FX Amount and its CV when FX is Clean
     NT_setParameterGrayedOut(idx, kParamFXAmount + off, clean);
     NT_setParameterGrayedOut(idx, kParamFXAmountCV + off, clean);
     
+    // Grey the body controls when the body is off
+    NT_setParameterGrayedOut(idx, kParamBodyTune + off, bodyOff);
+    NT_setParameterGrayedOut(idx, kParamBodyMix + off, bodyOff);
+    
     // Grey Env Output when Env Follower is off
     NT_setParameterGrayedOut(idx, kParamEnvOutput + off, envOff);
+    
+    // Grey each tap's mode while the tap has no bus
+    NT_setParameterGrayedOut(idx, kParamHighpassOutputMode + off, alg->v[kParamHighpassOutput] == 0);
+    NT_setParameterGrayedOut(idx, kParamBandpassOutputMode + off, alg->v[kParamBandpassOutput] == 0);
+    NT_setParameterGrayedOut(idx, kParamFilterGateOutputMode + off, alg->v[kParamFilterGateOutput] == 0);
+    NT_setParameterGrayedOut(idx, kParamVCAGateOutputMode + off, alg->v[kParamVCAGateOutput] == 0);
+    
+    // Grey the CPU budget when the governor is off
+    NT_setParameterGrayedOut(idx, kParamGovernorBudget + off, governorOff);
 }
 
 // ============================================================================
 // FACTORY FUNCTIONS
 // ============================================================================
 
+void calculateStaticRequirements(_NT_staticRequirements& req) {
+    req.dram = sizeof(HitCache) + HM_HIT_CACHE_BYTES;
+}
+
+// The hit cache goes first, as it holds pointers; its frames go last
+void initialise(_NT_staticMemoryPtrs& ptrs, const _NT_staticRequirements& req) {
+    uint8_t* dram = ptrs.dram;
+    sharedHitCache = new (dram) HitCache();
+    dram += sizeof(HitCache);
+    sharedHitCache->init(dram, HM_HIT_CACHE_BYTES);
+}
+
 void calculateRequirements(_NT_algorithmRequirements& req, const int32_t* specifications) {
     req.numParameters = kNumParams;
     req.sram = sizeof(_holyMackerelAlgorithm);
     req.dram = 0;
+#if HM_TRACE
+    req.dram += sizeof(TraceFrame) * HM_TRACE_LENGTH;
+#endif
+#if HM_CAPTURE
+    req.dram += HM_CAPTURE_BYTES;
+#endif
     req.dtc = 0;
     req.itc = 0;
 }
@@ -1122,14 +965,47 @@ _NT_algorithm* construct(const _NT_algorithmMemoryPtrs& ptrs, const _NT_algorith
     alg->parameterPages = &parameterPages;
     
     alg->sampleRate = (float)NT_globals.sampleRate;
+    alg->controlFrames = controlInterval(kControlRateHz, alg->sampleRate);
     alg->channelL.setSampleRate(alg->sampleRate);
     alg->channelR.setSampleRate(alg->sampleRate);
-    alg->trigger.setSampleRate(alg->sampleRate);
-    alg->trigger.reset();
-    alg->trigger.setThreshold(alg->v[kParamTriggerThreshold] / 1000.0f);
+    alg->strike.setSampleRate(alg->sampleRate);
+    alg->strike.reset();
+    alg->midiNotes.reset();
+    
+    ParamSnapshot initial;
+    readParamSnapshot(alg->v, initial);
+    alg->paramExchange.reset();
+    applyParamSnapshot(alg, initial, true);
     
     alg->hitIntensity = 0.0f;
     alg->hitPhase = 0.0f;
+    alg->activeTier = QUALITY_STANDARD;
+    alg->governor.reset();
+    alg->runFrames = 0;
+    alg->runSeconds = 0;
+    
+    // DRAM holds the diagnostic buffers, in the order calculateRequirements()
+    // sized them
+#if HM_TRACE || HM_CAPTURE
+    uint8_t* dram = ptrs.dram;
+#endif
+#if HM_TRACE
+    alg->trace.init((TraceFrame*)dram, HM_TRACE_LENGTH);
+    alg->trace.arm();
+    dram += sizeof(TraceFrame) * HM_TRACE_LENGTH;
+#endif
+#if HM_CAPTURE
+    alg->capture.init(dram, HM_CAPTURE_BYTES);
+    alg->capture.start(alg->sampleRate, alg->v, kNumParams);
+    alg->captureRestart = false;
+#endif
+    
+#if HM_PROFILE
+    profTimerInit();
+    alg->profiler.reset();
+    alg->channelL.setProfiler(&alg->profiler);
+    alg->channelR.setProfiler(&alg->profiler);
+#endif
     
     return alg;
 }
@@ -1137,62 +1013,126 @@ _NT_algorithm* construct(const _NT_algorithmMemoryPtrs& ptrs, const _NT_algorith
 void parameterChanged(_NT_algorithm* self, int p) {
     _holyMackerelAlgorithm* alg = (_holyMackerelAlgorithm*)self;
     
-    float resonance = alg->v[kParamResonance] / 100.0f;
-    float decay = alg->v[kParamDecay] / 100.0f;
-    float open = alg->v[kParamOpen] / 100.0f;
-    float dampening = alg->v[kParamDampening] / 100.0f;
-    MaterialMode material = (MaterialMode)alg->v[kParamMaterial];
-    FXMode fxMode = (FXMode)alg->v[kParamFX];
-    float fxAmount = alg->v[kParamFXAmount] / 100.0f;
-    float gain = getGainFromParam(alg->v[kParamGain]);
-    bool hitMemory = (alg->v[kParamHitMemory] == 1);
-    
-    alg->channelL.setParams(resonance, decay, open, dampening, material, fxMode, fxAmount, gain, hitMemory);
-    alg->channelR.setParams(resonance, decay, open, dampening, material, fxMode, fxAmount, gain, hitMemory);
-    
-    if (p == kParamTriggerThreshold) {
-        // Threshold in millivolts → volts
-        alg->trigger.setThreshold(alg->v[kParamTriggerThreshold] / 1000.0f);
-    }
+    HM_CAPTURE_DO(alg->capture.queueParam(p, alg->v[p]));
+    
+    // The DSP is left alone here: the next step() adopts the whole set
+    // and derives its coefficients itself
+    ParamSnapshot snapshot;
+    readParamSnapshot(alg->v, snapshot);
+    alg->paramExchange.publish(snapshot);
     
     // Update greying when relevant params change
-    if (p == kParamFX || p == kParamStereo || p == kParamEnvFollower) {
+    if (p == kParamFX || p == kParamStereo || p == kParamEnvFollower || p == kParamGovernor ||
+        p == kParamMidiChannel || p == kParamTriggerSource || p == kParamBody ||
+        p == kParamHighpassOutput || p == kParamBandpassOutput ||
+        p == kParamFilterGateOutput || p == kParamVCAGateOutput) {
         updateGrayed(alg);
     }
+    
+    if (p == kParamGovernor && alg->v[kParamGovernor]) {
+        // The timer is only touched once someone asks for the governor
+        // (step() resets the governor itself when it adopts the change)
+        profTimerInit();
+    }
+    
+#if HM_PROFILE
+    // Fresh statistics each time the CPU page is opened
+    if (p == kParamDisplay) {
+        alg->profiler.reset();
+    }
+#endif
+#if HM_TRACE
+    // Opening the Trace page arms a new capture
+    if (p == kParamDisplay && alg->v[kParamDisplay] == DISPLAY_TRACE) {
+        alg->trace.arm();
+    }
+#endif
+#if HM_CAPTURE
+    // Opening the Capture page restarts recording from a clean DSP state
+    // (step() picks the request up so the reset happens on the audio thread)
+    if (p == kParamDisplay && alg->v[kParamDisplay] == DISPLAY_CAPTURE) {
+        alg->captureRestart = true;
+    }
+#endif
+}
+
+void midiMessage(_NT_algorithm* self, uint8_t byte0, uint8_t byte1, uint8_t byte2) {
+    _holyMackerelAlgorithm* alg = (_holyMackerelAlgorithm*)self;
+    
+    // Everything is captured; replay filters it again with the same params
+    HM_CAPTURE_DO(alg->capture.queueMidi(byte0, byte1, byte2));
+    
+    int channelParam = alg->v[kParamMidiChannel];
+    if (channelParam == kMidiChannelOff) return;
+    if (channelParam != kMidiChannelOmni && (byte0 & 0x0F) + 1 != channelParam) return;
+    
+    // Note-on only; velocity 0 is a note-off by convention. The LPG is
+    // struck, not held, so note-offs have nothing to do.
+    if ((byte0 & 0xF0) != 0x90 || byte2 == 0) return;
+    alg->midiNotes.push(byte1 & 0x7F, byte2 & 0x7F);
 }
 
 // ============================================================================
 // AUDIO PROCESSING
 // ============================================================================
 
+// One chunk of scratch onto its bus, in the output's Add/Replace mode
+static inline void writeChunk(float* bus, const float* chunk, int numFrames, bool replace) {
+    if (replace) memcpy(bus, chunk, sizeof(float) * numFrames);
+    else for (int j = 0; j < numFrames; ++j) bus[j] += chunk[j];
+}
+
 void step(_NT_algorithm* self, float* busFrames, int numFramesBy4) {
     _holyMackerelAlgorithm* alg = (_holyMackerelAlgorithm*)self;
     int numFrames = numFramesBy4 * 4;
     
-    int trigBus = alg->v[kParamTriggerInput];
-    int lInBus = alg->v[kParamLeftInput] - 1;
-    int rInBus = alg->v[kParamRightInput] - 1;
-    int lOutBus = alg->v[kParamLeftOutput] - 1;
-    int rOutBus = alg->v[kParamRightOutput] - 1;
-    int envOutBus = alg->v[kParamEnvOutput];
-    bool lReplace = alg->v[kParamLeftOutputMode];
-    bool rReplace = alg->v[kParamRightOutputMode];
-    bool stereo = (alg->v[kParamStereo] == 1);
-    bool envFollowerOn = (alg->v[kParamEnvFollower] == 1);
-    
-    const float* trigIn = (trigBus > 0) ? busFrames + (trigBus - 1) * numFrames : nullptr;
+    // Parameter changes land on block boundaries, all together
+    ParamSnapshot next;
+    if (alg->paramExchange.adopt(next)) applyParamSnapshot(alg, next, false);
+    const ParamSnapshot& params = alg->params;
+    
+    int trigBus = params.triggerBus;
+    int lInBus = params.leftInput - 1;
+    int rInBus = params.rightInput - 1;
+    int lOutBus = params.leftOutput - 1;
+    int rOutBus = params.rightOutput - 1;
+    int envOutBus = params.envOutput;
+    bool lReplace = params.leftReplace;
+    bool rReplace = params.rightReplace;
+    bool stereo = params.stereo;
+    bool envFollowerOn = params.envFollower;
+    bool governed = params.governor;
+    uint32_t blockStart = governed ? profTimerRead() : 0;
+    
+    // Tier changes land on block boundaries
+    QualityTier userTier = params.quality;
+    QualityTier tier = governed ? alg->governor.getTier(userTier) : userTier;
+    if (tier != alg->activeTier) {
+        alg->activeTier = tier;
+        alg->channelL.setQuality(tier);
+        alg->channelR.setQuality(tier);
+    }
+    
+    bool audioTrigger = (params.triggerSource == TRIG_SOURCE_AUDIO);
+    bool cvGate = (params.triggerSource == TRIG_SOURCE_CV);
+    const float* trigIn = (!audioTrigger && trigBus > 0) ? busFrames + (trigBus - 1) * numFrames : nullptr;
     const float* lIn = busFrames + lInBus * numFrames;
     const float* rIn = stereo ? (busFrames + rInBus * numFrames) : lIn;
     float* lOut = busFrames + lOutBus * numFrames;
     float* rOut = stereo ? (busFrames + rOutBus * numFrames) : nullptr;
     // Env output respects the Env Follower on/off switch
     float* envOut = (envFollowerOn && envOutBus > 0) ? busFrames + (envOutBus - 1) * numFrames : nullptr;
-    
-    int resCVBus = alg->v[kParamResonanceCV];
-    int decCVBus = alg->v[kParamDecayCV];
-    int openCVBus = alg->v[kParamOpenCV];
-    int dampCVBus = alg->v[kParamDampeningCV];
-    int fxCVBus = alg->v[kParamFXAmountCV];
+    // Filter taps and raw gates, all from the left channel's pass
+    float* hpOut = (params.highpassOutput > 0) ? busFrames + (params.highpassOutput - 1) * numFrames : nullptr;
+    float* bpOut = (params.bandpassOutput > 0) ? busFrames + (params.bandpassOutput - 1) * numFrames : nullptr;
+    float* fgOut = (params.filterGateOutput > 0) ? busFrames + (params.filterGateOutput - 1) * numFrames : nullptr;
+    float* vgOut = (params.vcaGateOutput > 0) ? busFrames + (params.vcaGateOutput - 1) * numFrames : nullptr;
+    
+    int resCVBus = params.resonanceCV;
+    int decCVBus = params.decayCV;
+    int openCVBus = params.openCV;
+    int dampCVBus = params.dampeningCV;
+    int fxCVBus = params.fxAmountCV;
     
     const float* resCV = (resCVBus > 0) ? busFrames + (resCVBus - 1) * numFrames : nullptr;
     const float* decCV = (decCVBus > 0) ? busFrames + (decCVBus - 1) * numFrames : nullptr;
@@ -1200,61 +1140,189 @@ void step(_NT_algorithm* self, float* busFrames, int numFramesBy4) {
     const float* dampCV = (dampCVBus > 0) ? busFrames + (dampCVBus - 1) * numFrames : nullptr;
     const float* fxCV = (fxCVBus > 0) ? busFrames + (fxCVBus - 1) * numFrames : nullptr;
     
-    float baseRes = alg->v[kParamResonance] / 100.0f;
-    float baseDec = alg->v[kParamDecay] / 100.0f;
-    float baseOpen = alg->v[kParamOpen] / 100.0f;
-    float baseDamp = alg->v[kParamDampening] / 100.0f;
-    float baseFX = alg->v[kParamFXAmount] / 100.0f;
-    MaterialMode material = (MaterialMode)alg->v[kParamMaterial];
-    FXMode fxMode = (FXMode)alg->v[kParamFX];
-    float gain = getGainFromParam(alg->v[kParamGain]);
-    bool hitMemory = (alg->v[kParamHitMemory] == 1);
-    
-    for (int i = 0; i < numFrames; ++i) {
-        if (trigIn && alg->trigger.process(trigIn[i])) {
-            // Velocity: scale trigger level to 0.35-1.0 range
-            // Floor at 0.35 prevents natural trigger voltage wobble from
-            // creating wildly different hit intensities. Low enough for
-            // false triggers to be quiet, high enough for consistency.
-            float vel = clampf(alg->trigger.getLastLevel() / 5.0f, 0.35f, 1.0f);
-            alg->channelL.trigger(vel);
-            if (stereo) alg->channelR.trigger(vel);
-            
-            alg->hitIntensity = vel;
-            alg->hitPhase = 0.0f;
-        }
+    float baseRes = params.resonance;
+    float baseDec = params.decay;
+    float baseOpen = params.open;
+    float baseDamp = params.dampening;
+    float baseFX = params.fxAmount;
+    MaterialMode material = params.material;
+    FXMode fxMode = params.fxMode;
+    float gain = params.gain;
+    bool hitMemory = params.hitMemory;
+    
+#if HM_CAPTURE
+    if (alg->captureRestart) {
+        alg->captureRestart = false;
+        alg->channelL.reset();
+        alg->channelR.reset();
+        alg->strike.reset();
+        alg->midiNotes.reset();     // Their MIDI records predate the new stream
+        alg->capture.start(alg->sampleRate, alg->v, kNumParams);
+    }
+    if (alg->capture.isRecording()) {
+        const float* roles[kNumCaptureRoles] = {
+            lIn, stereo ? rIn : nullptr, trigIn,
+            resCV, decCV, openCV, dampCV, fxCV,
+            lReplace ? nullptr : lOut,
+            (rOut && !rReplace) ? rOut : nullptr,
+            params.highpassReplace ? nullptr : hpOut,
+            params.bandpassReplace ? nullptr : bpOut,
+            params.filterGateReplace ? nullptr : fgOut,
+            params.vcaGateReplace ? nullptr : vgOut
+        };
+        alg->capture.recordBlock(roles, numFrames);
+    }
+#endif
+    
+    HM_PROF(alg->profiler.beginBlock());
+    
+    // Denormals flush to zero until step() returns
+    FlushDenormalsScope flushDenormals;
+    
+    // MIDI notes that arrived since the last block fire on its first sample.
+    // Full 7-bit velocity - no floor, MIDI has no trigger voltage wobble.
+    int midiNoteL = params.midiNoteL;
+    int midiNoteR = params.midiNoteR;
+    MidiNote note;
+    while (alg->midiNotes.pop(note)) {
+        bool hitL = (midiNoteL == kMidiNoteAny || note.note == midiNoteL);
+        bool hitR = stereo && (midiNoteR == kMidiNoteAny || note.note == midiNoteR);
+        if (!hitL && !hitR) continue;
         
-        if (resCV || decCV || openCV || dampCV || fxCV) {
-            // Update every 32 samples (~1500Hz update rate)
-            if ((i & 31) == 0) {
-                float r = baseRes, d = baseDec, o = baseOpen, dp = baseDamp, f = baseFX;
-                if (resCV) r = clampf(baseRes + resCV[i] * 0.1f, 0.0f, 1.0f);
-                if (decCV) d = clampf(baseDec + decCV[i] * 0.1f, 0.0f, 1.0f);
-                if (openCV) o = clampf(baseOpen + openCV[i] * 0.1f, 0.0f, 1.0f);
-                if (dampCV) dp = clampf(baseDamp + dampCV[i] * 0.1f, 0.0f, 1.0f);
-                if (fxCV) f = clampf(baseFX + fxCV[i] * 0.1f, 0.0f, 1.0f);
+        float vel = note.velocity / 127.0f;
+        if (hitL) alg->channelL.trigger(vel);
+        if (hitR) alg->channelR.trigger(vel);
+        HM_TRACE_DO(alg->trace.onTrigger());
+        
+        alg->hitIntensity = vel;
+        alg->hitPhase = 0.0f;
+    }
+    
+    // Samples are rendered one control block at a time into scratch, checked
+    // once per block by the channels, then written to the buses in the
+    // original order
+    const int controlFrames = alg->controlFrames;
+    float chunkL[kMaxControlBlock];
+    float chunkR[kMaxControlBlock];
+    float chunkEnv[kMaxControlBlock];
+    float chunkHP[kMaxControlBlock];
+    float chunkBP[kMaxControlBlock];
+    float chunkFG[kMaxControlBlock];
+    float chunkVG[kMaxControlBlock];
+    
+    for (int chunkStart = 0; chunkStart < numFrames; chunkStart += controlFrames) {
+        int chunkFrames = numFrames - chunkStart;
+        if (chunkFrames > controlFrames) chunkFrames = controlFrames;
+        
+        for (int j = 0; j < chunkFrames; ++j) {
+            int i = chunkStart + j;
+            
+            float vel = 1.0f;
+            StrikeEvent strike = STRIKE_NONE;
+            if (cvGate) {
+                // 5V lights the LED fully; the channels sample it at control rate
+                float led = trigIn ? trigIn[i] * 0.2f : 0.0f;
+                alg->channelL.setLED(led);
+                if (stereo) alg->channelR.setLED(led);
+            } else if (audioTrigger) {
+                strike = alg->strike.process(lIn[i], vel);
+            } else if (trigIn) {
+                strike = alg->strike.process(trigIn[i], vel);
+            }
+            if (strike == STRIKE_FIRE) {
+                float onsetOffset = alg->strike.getOffset();
+                alg->channelL.trigger(vel, onsetOffset);
+                if (stereo) alg->channelR.trigger(vel, onsetOffset);
+                HM_TRACE_DO(alg->trace.onTrigger());
                 
-                alg->channelL.setParams(r, d, o, dp, material, fxMode, f, gain, hitMemory);
-                if (stereo) alg->channelR.setParams(r, d, o, dp, material, fxMode, f, gain, hitMemory);
+                alg->hitIntensity = vel;
+                alg->hitPhase = 0.0f;
+            } else if (strike == STRIKE_RAISE) {
+                alg->channelL.raiseVelocity(vel);
+                if (stereo) alg->channelR.raiseVelocity(vel);
+                alg->hitIntensity = vel;
+            }
+            HM_PROF(alg->profiler.lap(PROF_TRIGGER));
+            
+            if (resCV || decCV || openCV || dampCV || fxCV) {
+                // Once per control block (kControlRateHz, 32 samples at 48kHz)
+                if (j == 0) {
+                    float r = baseRes, d = baseDec, o = baseOpen, dp = baseDamp, f = baseFX;
+                    if (resCV) r = clampf(baseRes + resCV[i] * 0.1f, 0.0f, 1.0f);
+                    if (decCV) d = clampf(baseDec + decCV[i] * 0.1f, 0.0f, 1.0f);
+                    if (openCV) o = clampf(baseOpen + openCV[i] * 0.1f, 0.0f, 1.0f);
+                    if (dampCV) dp = clampf(baseDamp + dampCV[i] * 0.1f, 0.0f, 1.0f);
+                    if (fxCV) f = clampf(baseFX + fxCV[i] * 0.1f, 0.0f, 1.0f);
+                    
+                    alg->channelL.setParams(r, d, o, dp, material, fxMode, f, gain, hitMemory);
+                    if (stereo) alg->channelR.setParams(r, d, o, dp, material, fxMode, f, gain, hitMemory);
+                }
+            }
+            HM_PROF(alg->profiler.lap(PROF_CV));
+            
+            chunkL[j] = alg->channelL.process(lIn[i]);
+            HM_TRACE_DO(if (alg->trace.tick()) alg->channelL.fillTrace(alg->trace.nextFrame(), chunkL[j]));
+            HM_PROF(alg->profiler.lap(PROF_OUTPUT));
+            
+            // Gates scale to 0-5V like the env output
+            if (hpOut) chunkHP[j] = alg->channelL.getGatedHighpass();
+            if (bpOut) chunkBP[j] = alg->channelL.getGatedBandpass();
+            if (fgOut) chunkFG[j] = alg->channelL.getOutputFilterGate() * 5.0f;
+            if (vgOut) chunkVG[j] = alg->channelL.getOutputGate() * 5.0f;
+            
+            if (stereo && rOut) {
+                chunkR[j] = alg->channelR.process(rIn[i]);
             }
+            
+            if (envOut) {
+                float gateL = alg->channelL.getOutputGate();
+                float gateR = stereo ? alg->channelR.getOutputGate() : gateL;
+                chunkEnv[j] = ((gateL + gateR) * 0.5f) * 5.0f;
+            }
+            HM_PROF(alg->profiler.lap(PROF_OUTPUT));
         }
         
-        float outL = alg->channelL.process(lIn[i]);
-        
-        if (lReplace) lOut[i] = outL;
-        else lOut[i] += outL;
-        
-        if (stereo && rOut) {
-            float outR = alg->channelR.process(rIn[i]);
-            if (rReplace) rOut[i] = outR;
-            else rOut[i] += outR;
+        if (alg->channelL.recoverChunk(chunkL, chunkFrames)) {
+            // The taps came from the same bad state
+            memset(chunkHP, 0, sizeof(chunkHP));
+            memset(chunkBP, 0, sizeof(chunkBP));
         }
+        if (stereo && rOut) alg->channelR.recoverChunk(chunkR, chunkFrames);
         
-        if (envOut) {
-            float gateL = alg->channelL.getGateValue();
-            float gateR = stereo ? alg->channelR.getGateValue() : gateL;
-            envOut[i] = ((gateL + gateR) * 0.5f) * 5.0f;
-        }
+        writeChunk(lOut + chunkStart, chunkL, chunkFrames, lReplace);
+        if (stereo && rOut) writeChunk(rOut + chunkStart, chunkR, chunkFrames, rReplace);
+        
+        if (envOut) memcpy(envOut + chunkStart, chunkEnv, sizeof(float) * chunkFrames);
+        if (hpOut) writeChunk(hpOut + chunkStart, chunkHP, chunkFrames, params.highpassReplace);
+        if (bpOut) writeChunk(bpOut + chunkStart, chunkBP, chunkFrames, params.bandpassReplace);
+        if (fgOut) writeChunk(fgOut + chunkStart, chunkFG, chunkFrames, params.filterGateReplace);
+        if (vgOut) writeChunk(vgOut + chunkStart, chunkVG, chunkFrames, params.vcaGateReplace);
+        HM_PROF(alg->profiler.lap(PROF_OUTPUT));
+    }
+    
+    HM_PROF(alg->profiler.endBlock(numFrames));
+    
+    if (governed) {
+        float blockSeconds = numFrames / alg->sampleRate;
+        float load = (float)(profTimerRead() - blockStart) / (blockSeconds * kProfTicksPerSecond);
+        alg->governor.update(load, params.governorBudget, blockSeconds, userTier);
+    }
+    
+#if HM_CAPTURE
+    uint32_t outHash = captureHash(kCaptureHashSeed, lOut, numFrames);
+    if (rOut) outHash = captureHash(outHash, rOut, numFrames);
+    if (envOut) outHash = captureHash(outHash, envOut, numFrames);
+    if (hpOut) outHash = captureHash(outHash, hpOut, numFrames);
+    if (bpOut) outHash = captureHash(outHash, bpOut, numFrames);
+    if (fgOut) outHash = captureHash(outHash, fgOut, numFrames);
+    if (vgOut) outHash = captureHash(outHash, vgOut, numFrames);
+    alg->capture.recordHash(outHash);
+#endif
+    
+    alg->runFrames += numFrames;
+    if (alg->runFrames >= (uint32_t)alg->sampleRate) {
+        alg->runFrames -= (uint32_t)alg->sampleRate;
+        alg->runSeconds++;
     }
     
     alg->hitPhase += 0.06f;
@@ -1267,9 +1335,176 @@ void step(_NT_algorithm* self, float* busFrames, int numFramesBy4) {
 // UI
 // ============================================================================
 
+// CPU page: per-stage min/avg/max per sample, plus average share of the
+// per-sample deadline. Rows fit the 64px screen under the parameter line.
+static void drawProfilePage(_holyMackerelAlgorithm* alg) {
+#if HM_PROFILE
+    static const char* const stageNames[StageProfiler::kNumRows] = {
+        "TRIG", "CV", "ENV", "FILT", "BODY", "FX", "OUT", "STEP"
+    };
+    const StageProfiler& prof = alg->profiler;
+    // Deadline per sample in timer ticks
+    float budget = kProfTicksPerSecond / alg->sampleRate;
+    char buf[16];
+    
+    NT_drawText(4, 14, kProfTickUnit, 8, kNT_textLeft, kNT_textTiny);
+    NT_drawText(90, 14, "MIN", 8, kNT_textRight, kNT_textTiny);
+    NT_drawText(130, 14, "AVG", 8, kNT_textRight, kNT_textTiny);
+    NT_drawText(170, 14, "MAX", 8, kNT_textRight, kNT_textTiny);
+    NT_drawText(210, 14, "%BUDGET", 8, kNT_textRight, kNT_textTiny);
+    snprintf(buf, sizeof(buf), "%lu", (unsigned long)prof.getNumBlocks());
+    NT_drawText(250, 14, buf, 5, kNT_textRight, kNT_textTiny);
+    
+    for (int row = 0; row < StageProfiler::kNumRows; row++) {
+        int y = 21 + row * 6;
+        int colour = (row == kNumProfStages) ? 15 : 11;
+        NT_drawText(4, y, stageNames[row], colour, kNT_textLeft, kNT_textTiny);
+        snprintf(buf, sizeof(buf), "%d", (int)prof.getMin(row));
+        NT_drawText(90, y, buf, colour, kNT_textRight, kNT_textTiny);
+        snprintf(buf, sizeof(buf), "%d", (int)prof.getAvg(row));
+        NT_drawText(130, y, buf, colour, kNT_textRight, kNT_textTiny);
+        snprintf(buf, sizeof(buf), "%d", (int)prof.getMax(row));
+        NT_drawText(170, y, buf, colour, kNT_textRight, kNT_textTiny);
+        // Tenths of a percent without pulling float printf into the plugin
+        int permille = (int)(prof.getAvg(row) * 1000.0f / budget);
+        snprintf(buf, sizeof(buf), "%d.%d", permille / 10, permille % 10);
+        NT_drawText(210, y, buf, colour, kNT_textRight, kNT_textTiny);
+    }
+#else
+    NT_drawText(128, 32, "Profiling not built in", 8, kNT_textCentre, kNT_textTiny);
+    NT_drawText(128, 42, "(compile with HM_PROFILE=1)", 5, kNT_textCentre, kNT_textTiny);
+#endif
+}
+
+#if HM_HEALTH
+static void collectHealth(const _holyMackerelAlgorithm* alg, HealthCounters& h) {
+    alg->channelL.addHealth(h);
+    alg->channelR.addHealth(h);
+    alg->strike.addHealth(h);
+}
+#endif
+
+// Health page: cumulative recovery-path counts since the algorithm was loaded
+static void drawHealthPage(_holyMackerelAlgorithm* alg) {
+#if HM_HEALTH
+    HealthCounters h;
+    collectHealth(alg, h);
+    char buf[24];
+    
+    NT_drawText(4, 14, "EVENT", 8, kNT_textLeft, kNT_textTiny);
+    NT_drawText(150, 14, "COUNT", 8, kNT_textRight, kNT_textTiny);
+    snprintf(buf, sizeof(buf), "%lus", (unsigned long)alg->runSeconds);
+    NT_drawText(250, 14, buf, 5, kNT_textRight, kNT_textTiny);
+    
+    for (int e = 0; e < kNumHealthEvents; e++) {
+        int y = 22 + e * 7;
+        // Highlight anything that has fired
+        int colour = h.count[e] ? 15 : 6;
+        NT_drawText(4, y, healthEventNames[e], colour, kNT_textLeft, kNT_textTiny);
+        snprintf(buf, sizeof(buf), "%lu", (unsigned long)h.count[e]);
+        NT_drawText(150, y, buf, colour, kNT_textRight, kNT_textTiny);
+    }
+#else
+    NT_drawText(128, 32, "Health counters not built in", 8, kNT_textCentre, kNT_textTiny);
+    NT_drawText(128, 42, "(compile with HM_HEALTH=1)", 5, kNT_textCentre, kNT_textTiny);
+#endif
+}
+
+// Trace page: capture status plus vactrol/filter/VCA curves of the window
+static void drawTracePage(_holyMackerelAlgorithm* alg) {
+#if HM_TRACE
+    static const char* const stateNames[] = { "IDLE", "ARMED", "CAPTURING", "DONE" };
+    const StateTrace& trace = alg->trace;
+    char buf[32];
+    
+    NT_drawText(4, 14, stateNames[trace.getState()], 15, kNT_textLeft, kNT_textTiny);
+    int windowMs = (int)(1000.0f * HM_TRACE_LENGTH * trace.getDecimation() / alg->sampleRate);
+    snprintf(buf, sizeof(buf), "%dms /%d", windowMs, trace.getDecimation());
+    NT_drawText(250, 14, buf, 5, kNT_textRight, kNT_textTiny);
+    NT_drawText(90, 14, "VAC", 5, kNT_textLeft, kNT_textTiny);
+    NT_drawText(110, 14, "FILT", 9, kNT_textLeft, kNT_textTiny);
+    NT_drawText(135, 14, "VCA", 15, kNT_textLeft, kNT_textTiny);
+    
+    int numFrames = trace.getNumFrames();
+    if (numFrames < 2) return;
+    
+    const int plotX0 = 4, plotX1 = 250;
+    const int plotTop = 20, plotBottom = 62;
+    const int width = plotX1 - plotX0;
+    const float scale = (float)(plotBottom - plotTop) / 1.2f;  // State peaks at 1.2 with Hit Memory
+    static const int fields[3] = { TRACE_VACTROL, TRACE_FILTER_GATE, TRACE_VCA_GATE };
+    static const int colours[3] = { 5, 9, 15 };
+    
+    int trig = trace.getTriggerIndex();
+    if (trig >= 0) {
+        int tx = plotX0 + trig * width / numFrames;
+        NT_drawShapeI(kNT_line, tx, plotTop, tx, plotBottom, 3);
+    }
+    
+    for (int f = 0; f < 3; f++) {
+        int prevY = 0;
+        for (int x = 0; x <= width; x++) {
+            int idx = x * (numFrames - 1) / width;
+            float v = clampf(trace.getFrame(idx).v[fields[f]], 0.0f, 1.2f);
+            int y = plotBottom - (int)(v * scale);
+            if (x > 0) NT_drawShapeI(kNT_line, plotX0 + x - 1, prevY, plotX0 + x, y, colours[f]);
+            prevY = y;
+        }
+    }
+#else
+    NT_drawText(128, 32, "State trace not built in", 8, kNT_textCentre, kNT_textTiny);
+    NT_drawText(128, 42, "(compile with HM_TRACE=1)", 5, kNT_textCentre, kNT_textTiny);
+#endif
+}
+
+// Capture page: recording status and how much of the buffer is used
+static void drawCapturePage(_holyMackerelAlgorithm* alg) {
+#if HM_CAPTURE
+    const BusCapture& cap = alg->capture;
+    char buf[32];
+    
+    NT_drawText(4, 14, cap.isRecording() ? "RECORDING" : "FULL", 15, kNT_textLeft, kNT_textTiny);
+    snprintf(buf, sizeof(buf), "%lu blocks", (unsigned long)cap.getNumBlocks());
+    NT_drawText(4, 24, buf, 11, kNT_textLeft, kNT_textTiny);
+    snprintf(buf, sizeof(buf), "%lu / %lu KB", (unsigned long)(cap.getBytesUsed() >> 10),
+             (unsigned long)(cap.getCapacity() >> 10));
+    NT_drawText(4, 32, buf, 11, kNT_textLeft, kNT_textTiny);
+    if (cap.getDroppedEvents()) {
+        snprintf(buf, sizeof(buf), "%lu events lost", (unsigned long)cap.getDroppedEvents());
+        NT_drawText(4, 40, buf, 15, kNT_textLeft, kNT_textTiny);
+    }
+    
+    // Fill bar
+    const int barX0 = 4, barX1 = 250, barY0 = 50, barY1 = 56;
+    NT_drawShapeI(kNT_box, barX0, barY0, barX1, barY1, 6);
+    int fill = (int)((float)cap.getBytesUsed() / (float)cap.getCapacity() * (barX1 - barX0 - 2));
+    if (fill > 0) NT_drawShapeI(kNT_rectangle, barX0 + 1, barY0 + 1, barX0 + 1 + fill, barY1 - 1, 11);
+#else
+    NT_drawText(128, 32, "Bus capture not built in", 8, kNT_textCentre, kNT_textTiny);
+    NT_drawText(128, 42, "(compile with HM_CAPTURE=1)", 5, kNT_textCentre, kNT_textTiny);
+#endif
+}
+
 bool draw(_NT_algorithm* self) {
     _holyMackerelAlgorithm* alg = (_holyMackerelAlgorithm*)self;
     
+    if (alg->v[kParamDisplay] == DISPLAY_CPU) {
+        drawProfilePage(alg);
+        return false;
+    }
+    if (alg->v[kParamDisplay] == DISPLAY_HEALTH) {
+        drawHealthPage(alg);
+        return false;
+    }
+    if (alg->v[kParamDisplay] == DISPLAY_TRACE) {
+        drawTracePage(alg);
+        return false;
+    }
+    if (alg->v[kParamDisplay] == DISPLAY_CAPTURE) {
+        drawCapturePage(alg);
+        return false;
+    }
+    
     const int yOffset = 6;
     
     const int faderX = 4;
@@ -1325,7 +1560,17 @@ bool draw(_NT_algorithm* self) {
     if (alg->v[kParamHitMemory] == 1) {
         NT_drawText(95, faderBottomY + 6, "MEM", 12, kNT_textCentre, kNT_textTiny);
     }
-    
+
+    // Quality tier indicator - hidden at Standard, "*" when the governor lowered it
+    QualityTier tier = alg->activeTier;
+    bool limited = (tier != (QualityTier)alg->v[kParamQuality]);
+    if (tier != QUALITY_STANDARD || limited) {
+        const char* tierStr[] = { "ECO", "STD", "HQ" };
+        char tierBuf[8];
+        snprintf(tierBuf, sizeof(tierBuf), "%s%s", tierStr[tier], limited ? "*" : "");
+        NT_drawText(120, faderBottomY + 6, tierBuf, limited ? 15 : 8, kNT_textCentre, kNT_textTiny);
+    }
+
     // Gate visualization
     const int hitCenterX = 175;
     const int hitCenterY = 32 + yOffset;
@@ -1414,15 +1659,15 @@ static const _NT_factory factory = {
     .description = "Low Pass Gate with Smile Pass filter and Hate - The Reunion",
     .numSpecifications = 0,
     .specifications = nullptr,
-    .calculateStaticRequirements = nullptr,
-    .initialise = nullptr,
+    .calculateStaticRequirements = calculateStaticRequirements,
+    .initialise = initialise,
     .calculateRequirements = calculateRequirements,
     .construct = construct,
     .parameterChanged = parameterChanged,
     .step = step,
     .draw = draw,
     .midiRealtime = nullptr,
-    .midiMessage = nullptr,
+    .midiMessage = midiMessage,
     .tags = kNT_tagFilterEQ | kNT_tagEffect,
     .hasCustomUi = nullptr,
     .customUi = nullptr,
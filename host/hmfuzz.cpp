@@ -0,0 +1,995 @@
+/*
+ * hmfuzz - differential fuzzer: the engine's kernels against hmReference.h
+ *
+ * Generates random cases and runs each optimized kernel side by side with
+ * the plain per-sample reference (engine/hmReference.h). A case is:
+ *   - settings
+ *   - an input signal
+ *   - CV waveforms on the CV-able parameters
+ *   - an LED waveform (CV mode)
+ *   - triggers, velocity raises and parameter changes at given frames
+ *   - a block size
+ * Both sides receive exactly the same calls, with the same timing the
+ * plugin uses:
+ *   - parameter changes land on block boundaries
+ *   - CV is re-applied once per control block (32 samples at 48kHz)
+ *   - the engine side runs recoverChunk() once per chunk
+ *
+ * The first sample where |opt - ref| > abs + rel * |ref| is a divergence.
+ * The failing case is then reduced:
+ *   - truncated to the divergence
+ *   - stripped of every event, waveform and setting it doesn't need
+ *   - given a simpler input and block size
+ * and printed as a one-line spec that --case runs again.
+ *
+ * Usage: hmfuzz [options]
+ *   --cases <n>        cases per kernel (default 300)
+ *   --seed <n>         first case seed (default 1)
+ *   --kernel <name>    check only this kernel (repeatable; see --list)
+ *   --max-length <n>   longest case in samples (default 24000)
+ *   --tolerance <x>    scale every kernel's tolerance (default 1)
+ *   --case "<spec>"    run one case and show the samples around its
+ *                      divergence, e.g. a reproducer from an earlier run
+ *   --list             print the kernels and their tolerances
+ *
+ * Exit status is 1 if any kernel diverged.
+ */
+
+#include "../engine/hmEngine.h"
+#include "../engine/hmReference.h"
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <string>
+#include <vector>
+
+// The reference keeps the constants as voiced at 48kHz rather than
+// re-deriving them per rate, so cases run there
+static const float kSampleRate = 48000.0f;
+
+// ============================================================================
+// KERNELS - What is checked, and how far it may stray from the reference
+//
+// Standard and HQ run the reference math in a different shape, so their
+// audio is compared sample by sample with float-noise tolerances. Two
+// places can turn that noise into a step: Grit's bit crusher, a whole
+// quantisation step (none in the seeds below), and the envelope's cutoff
+// to silence, which may trip one sample apart (hence the channels'
+// one-sample lag). Eco and
+// CV mode approximate on purpose, and a small envelope or cutoff offset
+// puts the audio out of phase. So those kernels are checked on the signal
+// they approximate (the VCA gate, or the filter cutoff), which may run up to
+// one update interval early or late: each sample has to lie within the
+// reference's range over +-lag samples. The Eco filter is the exception: it
+// takes one smoothing step per hold, from the gate at the hold's start, so
+// its reference is fed the same held inputs and the two are compared where
+// each hold ends, to float noise.
+//
+// Worst error over seeds 1-20000, and the share of the tolerance it used:
+//
+//   filter         0          0.00   (bit-identical)
+//   filter-eco     1.95e-3 Hz 0.24   (3.2e-7 relative)
+//   fx             9.04e-4    0.30
+//   fx-2x          6.13e-4    0.19
+//   channel        2.66e-4    0.28
+//   channel-eco    0.0411     0.51
+//   channel-hq     1.37e-4    0.24
+//   channel-cv     0.105      0.47
+//   channel-cache  7.16e-4    0.34
+//
+// Every kernel keeps 2-5x over that, and no more: a 1% error in one
+// FXCoefficients value (makeup, or the Tube/Screamer/Grit drive) fails
+// fx, fx-2x and the channels within the first ten seeds.
+// ============================================================================
+
+enum FuzzKernel {
+    KERNEL_FILTER = 0,
+    KERNEL_FILTER_ECO,
+    KERNEL_FX,
+    KERNEL_FX_2X,
+    KERNEL_CHANNEL,
+    KERNEL_CHANNEL_ECO,
+    KERNEL_CHANNEL_HQ,
+    KERNEL_CHANNEL_CV,
+    KERNEL_CHANNEL_CACHE,
+    kNumKernels
+};
+
+enum Observable {
+    OBSERVE_OUTPUT = 0,
+    OBSERVE_GATE,           // LPGChannel::getGateValue()
+    OBSERVE_CUTOFF,         // BuchlaLPGFilter::getCutoff(), Hz
+    kNumObservables
+};
+static const char* const kObservableNames[kNumObservables] = { "output", "gate", "cutoff" };
+
+struct KernelInfo {
+    const char* name;
+    int observe;
+    int lag;            // Samples the kernel may lead or trail the reference
+    bool held;          // Compared only on the last sample of each Eco hold
+    float absTol;
+    float relTol;
+    const char* what;
+};
+
+static const KernelInfo kKernels[kNumKernels] = {
+    { "filter",      OBSERVE_OUTPUT, 0,  false, 1.0e-4f, 1.0e-3f, "BuchlaLPGFilter, Standard" },
+    { "filter-eco",  OBSERVE_CUTOFF, 0,  true,  1.0e-3f, 1.0e-6f, "BuchlaLPGFilter, Eco held coefficients" },
+    { "fx",          OBSERVE_OUTPUT, 0,  false, 3.0e-3f, 6.0e-3f, "FXProcessor at 1x" },
+    { "fx-2x",       OBSERVE_OUTPUT, 0,  false, 2.0e-3f, 6.0e-3f, "FXProcessor at 2x (HQ rate)" },
+    { "channel",     OBSERVE_OUTPUT, 1,  false, 3.0e-4f, 3.0e-3f, "LPGChannel, Standard" },
+    { "channel-eco", OBSERVE_GATE,   8,  false, 0.02f,   0.2f,    "LPGChannel, Eco control-rate envelope" },
+    { "channel-hq",  OBSERVE_OUTPUT, 1,  false, 3.0e-4f, 3.0e-3f, "LPGChannel, HQ oversampled FX" },
+    { "channel-cv",  OBSERVE_GATE,   32, false, 0.02f,   0.3f,    "LPGChannel, CV mode control-rate envelope" },
+    { "channel-cache", OBSERVE_OUTPUT, 1, false, 2.0e-4f, 0.01f, "LPGChannel, Standard, hit cache replaying" },
+};
+
+static bool isChannelKernel(int k) { return k >= KERNEL_CHANNEL; }
+static bool isFilterKernel(int k) { return k == KERNEL_FILTER || k == KERNEL_FILTER_ECO; }
+
+// ============================================================================
+// CASES - Settings, signals and events, all reproducible from the spec line
+// ============================================================================
+
+enum FuzzField {
+    FIELD_RESONANCE = 0,
+    FIELD_DECAY,
+    FIELD_OPEN,
+    FIELD_DAMPENING,
+    FIELD_MATERIAL,
+    FIELD_FX,
+    FIELD_FX_AMOUNT,
+    FIELD_GAIN,
+    FIELD_HIT_MEMORY,
+    FIELD_BODY,
+    FIELD_BODY_TUNE,
+    FIELD_BODY_MIX,
+    kNumFields
+};
+
+struct FieldInfo {
+    const char* key;
+    float def;
+    float lo;
+    float hi;
+    bool integer;
+};
+
+static const FieldInfo kFields[kNumFields] = {
+    { "res",    0.0f,   0.0f,   1.0f,  false },
+    { "decay",  0.5f,   0.0f,   1.0f,  false },
+    { "open",   1.0f,   0.0f,   1.0f,  false },
+    { "damp",   0.0f,   0.0f,   1.0f,  false },
+    { "mat",    0.0f,   0.0f,   2.0f,  true },
+    { "fx",     0.0f,   0.0f,   3.0f,  true },
+    { "amount", 0.0f,   0.0f,   1.0f,  false },
+    { "gain",   1.0f,   0.0f,   2.0f,  false },
+    { "memory", 0.0f,   0.0f,   1.0f,  true },
+    { "body",   0.0f,   0.0f,   1.0f,  true },
+    { "tune",   0.0f, -24.0f,  24.0f,  true },
+    { "mix",    0.5f,   0.0f,   1.0f,  false },
+};
+
+// Parameters the plugin has CV inputs for
+static const int kCVFields[] = { FIELD_RESONANCE, FIELD_DECAY, FIELD_OPEN, FIELD_DAMPENING, FIELD_FX_AMOUNT };
+
+enum WaveShape {
+    WAVE_NONE = 0,      // Input only: silence
+    WAVE_SINE,
+    WAVE_SQUARE,
+    WAVE_RAMP,
+    WAVE_STEPS,         // Random level per period
+    WAVE_NOISE,
+    kNumWaveShapes
+};
+static const char* const kWaveNames[kNumWaveShapes] = { "none", "sine", "square", "ramp", "steps", "noise" };
+
+struct FuzzWave {
+    int shape = WAVE_NONE;
+    float rate = 1.0f;      // Hz
+    float depth = 0.0f;     // Peak
+    int field = -1;         // CV target; -1 for the input and the LED
+};
+
+enum EventType {
+    EVENT_TRIGGER = 't',    // a = velocity, b = sub-sample offset
+    EVENT_RAISE = 'r',      // a = velocity
+    EVENT_PARAM = 'p'       // field = a's target
+};
+
+struct FuzzEvent {
+    int frame;
+    char type;
+    int field;
+    float a;
+    float b;
+};
+
+struct FuzzCase {
+    int kernel = KERNEL_CHANNEL;
+    int length = 4800;
+    int blockSize = 32;
+    float settings[kNumFields];
+    FuzzWave input;
+    FuzzWave led;
+    std::vector<FuzzWave> cvs;
+    std::vector<FuzzEvent> events;      // Sorted by frame
+    
+    FuzzCase() {
+        for (int f = 0; f < kNumFields; f++) settings[f] = kFields[f].def;
+    }
+};
+
+static inline uint32_t hash32(uint32_t x) {
+    x ^= x >> 16;
+    x *= 0x7feb352du;
+    x ^= x >> 15;
+    x *= 0x846ca68bu;
+    x ^= x >> 16;
+    return x;
+}
+
+// -1..1, a pure function of the frame, so a truncated case sees the same signal
+static float waveAt(const FuzzWave& w, int n) {
+    float t = (float)n * w.rate / kSampleRate;
+    float phase = t - floorf(t);
+    float v;
+    switch (w.shape) {
+        case WAVE_SINE:   v = sinf(TWO_PI * phase); break;
+        case WAVE_SQUARE: v = phase < 0.5f ? 1.0f : -1.0f; break;
+        case WAVE_RAMP:   v = phase * 2.0f - 1.0f; break;
+        case WAVE_STEPS:  v = (float)(hash32((uint32_t)floorf(t) * 2654435761u + 17u) >> 8) / 8388608.0f - 1.0f; break;
+        case WAVE_NOISE:  v = (float)(hash32((uint32_t)n + 0x9e3779b9u) >> 8) / 8388608.0f - 1.0f; break;
+        default:          v = 0.0f; break;
+    }
+    return v * w.depth;
+}
+
+class FuzzRng {
+public:
+    explicit FuzzRng(uint32_t seed) : state(hash32(seed) | 1u) {}
+    uint32_t next() {
+        state = state * 1664525u + 1013904223u;
+        return hash32(state);
+    }
+    float uniform(float lo, float hi) { return lo + (hi - lo) * (float)(next() >> 8) / 16777216.0f; }
+    int below(int n) { return (int)(next() % (uint32_t)n); }
+    bool chance(float p) { return uniform(0.0f, 1.0f) < p; }
+    float logUniform(float lo, float hi) { return lo * expf(uniform(0.0f, 1.0f) * logf(hi / lo)); }
+
+private:
+    uint32_t state;
+};
+
+static float randomFieldValue(FuzzRng& rng, int f) {
+    const FieldInfo& info = kFields[f];
+    if (info.integer) return info.lo + (float)rng.below((int)(info.hi - info.lo) + 1);
+    return rng.uniform(info.lo, info.hi);
+}
+
+static FuzzCase generateCase(int kernel, uint32_t seed, int maxLength) {
+    FuzzRng rng(seed * (uint32_t)kNumKernels + (uint32_t)kernel);
+    FuzzCase c;
+    c.kernel = kernel;
+    c.length = 256 + rng.below(maxLength > 256 ? maxLength - 255 : 1);
+    static const int kBlockSizes[] = { 1, 4, 7, 16, 24, 32, 48, 64, 100, 128, 256 };
+    c.blockSize = kBlockSizes[rng.below((int)ARRAY_SIZE(kBlockSizes))];
+    
+    for (int f = 0; f < kNumFields; f++) {
+        if (rng.chance(0.7f)) c.settings[f] = randomFieldValue(rng, f);
+    }
+    if (kernel == KERNEL_FX || kernel == KERNEL_FX_2X) {
+        c.settings[FIELD_FX] = (float)(1 + rng.below(3));
+        c.settings[FIELD_FX_AMOUNT] = rng.uniform(0.0f, 1.0f);
+    }
+    if (!isChannelKernel(kernel)) c.settings[FIELD_BODY] = 0.0f;
+    
+    c.input.shape = 1 + rng.below(kNumWaveShapes - 1);
+    c.input.rate = rng.logUniform(20.0f, 12000.0f);
+    c.input.depth = rng.logUniform(0.05f, 5.0f);
+    
+    if (kernel == KERNEL_CHANNEL_CV) {
+        c.led.shape = 1 + rng.below(WAVE_STEPS);      // Control signals: no white noise
+        c.led.rate = rng.logUniform(0.5f, 40.0f);
+        c.led.depth = rng.uniform(0.2f, 1.2f);
+    }
+    
+    int numCVs = rng.below(3);
+    for (int i = 0; i < numCVs; i++) {
+        FuzzWave cv;
+        cv.field = kCVFields[rng.below((int)ARRAY_SIZE(kCVFields))];
+        cv.shape = 1 + rng.below(WAVE_STEPS);
+        cv.rate = rng.logUniform(0.1f, 200.0f);
+        cv.depth = rng.uniform(0.05f, 1.0f);
+        c.cvs.push_back(cv);
+    }
+    
+    // The hit cache only replays exact repeats, so its strikes come from a
+    // small palette: a few velocities, on-sample or a quarter sample late.
+    // Some miss it by a hair, and have to play live.
+    static const float kPaletteVelocities[] = { 0.3f, 0.75f, 1.0f };
+    bool palette = (kernel == KERNEL_CHANNEL_CACHE);
+    int numTriggers = rng.below(palette ? 24 : 10);
+    for (int i = 0; i < numTriggers; i++) {
+        FuzzEvent e = { rng.below(c.length), EVENT_TRIGGER, -1, rng.uniform(0.05f, 1.0f), 0.0f };
+        if (rng.chance(0.5f)) e.b = rng.uniform(0.0f, 1.0f);
+        if (palette) {
+            e.a = kPaletteVelocities[rng.below((int)ARRAY_SIZE(kPaletteVelocities))];
+            e.b = rng.chance(0.5f) ? 0.25f : 0.0f;
+            if (rng.chance(0.25f)) e.a -= 1.0e-6f;
+            if (rng.chance(0.25f)) e.b += 1.0e-6f;
+        }
+        c.events.push_back(e);
+        if (rng.chance(0.2f)) {
+            FuzzEvent raise = { e.frame + 1 + rng.below(64), EVENT_RAISE, -1, rng.uniform(e.a, 1.0f), 0.0f };
+            if (raise.frame < c.length) c.events.push_back(raise);
+        }
+    }
+    int numChanges = rng.below(5);
+    for (int i = 0; i < numChanges; i++) {
+        int f = rng.below(kNumFields);
+        if (f == FIELD_BODY && !isChannelKernel(kernel)) continue;
+        FuzzEvent e = { rng.below(c.length), EVENT_PARAM, f, randomFieldValue(rng, f), 0.0f };
+        c.events.push_back(e);
+    }
+    
+    // HQ oversamples only while FX is on. Switch it off and back on while
+    // a hit rings, so the oversampler restarts with audio still in it.
+    if (kernel == KERNEL_CHANNEL_HQ && rng.chance(0.5f)) {
+        c.settings[FIELD_FX] = (float)(1 + rng.below(3));
+        int hit = rng.below(c.length / 2);
+        int off = hit + 1 + rng.below(2400);
+        int on = off + 1 + rng.below(1200);
+        FuzzEvent strike = { hit, EVENT_TRIGGER, -1, rng.uniform(0.3f, 1.0f), 0.0f };
+        FuzzEvent clean = { off, EVENT_PARAM, FIELD_FX, 0.0f, 0.0f };
+        FuzzEvent back = { on, EVENT_PARAM, FIELD_FX, (float)(1 + rng.below(3)), 0.0f };
+        c.events.push_back(strike);
+        if (off < c.length) c.events.push_back(clean);
+        if (on < c.length) c.events.push_back(back);
+    }
+    
+    // Stable by frame, so same-frame events keep their generated order
+    for (size_t i = 1; i < c.events.size(); i++) {
+        for (size_t j = i; j > 0 && c.events[j - 1].frame > c.events[j].frame; j--) {
+            std::swap(c.events[j - 1], c.events[j]);
+        }
+    }
+    return c;
+}
+
+// ============================================================================
+// SPEC LINES - A case as one line of text, and back
+// ============================================================================
+
+static void appendf(std::string& s, const char* fmt, ...) __attribute__((format(printf, 2, 3)));
+static void appendf(std::string& s, const char* fmt, ...) {
+    char buf[256];
+    va_list args;
+    va_start(args, fmt);
+    vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+    s += buf;
+}
+
+static void appendWave(std::string& s, const FuzzWave& w) {
+    appendf(s, "%s:%.9g:%.9g", kWaveNames[w.shape], w.rate, w.depth);
+}
+
+static std::string formatCase(const FuzzCase& c) {
+    std::string s = kKernels[c.kernel].name;
+    appendf(s, " n=%d block=%d in=", c.length, c.blockSize);
+    appendWave(s, c.input);
+    for (int f = 0; f < kNumFields; f++) {
+        if (c.settings[f] != kFields[f].def) appendf(s, " %s=%.9g", kFields[f].key, c.settings[f]);
+    }
+    if (c.led.shape != WAVE_NONE) {
+        s += " led=";
+        appendWave(s, c.led);
+    }
+    for (const FuzzWave& cv : c.cvs) {
+        appendf(s, " cv=%s:", kFields[cv.field].key);
+        appendWave(s, cv);
+    }
+    for (const FuzzEvent& e : c.events) {
+        if (e.type == EVENT_TRIGGER) appendf(s, " t@%d:%.9g:%.9g", e.frame, e.a, e.b);
+        else if (e.type == EVENT_RAISE) appendf(s, " r@%d:%.9g", e.frame, e.a);
+        else appendf(s, " p@%d:%s=%.9g", e.frame, kFields[e.field].key, e.a);
+    }
+    return s;
+}
+
+static int findField(const char* key, size_t len) {
+    for (int f = 0; f < kNumFields; f++) {
+        if (strlen(kFields[f].key) == len && strncmp(kFields[f].key, key, len) == 0) return f;
+    }
+    return -1;
+}
+
+static bool parseWave(const char* text, FuzzWave& w) {
+    char name[16];
+    if (sscanf(text, "%15[a-z]:%f:%f", name, &w.rate, &w.depth) != 3) return false;
+    for (int s = 0; s < kNumWaveShapes; s++) {
+        if (strcmp(name, kWaveNames[s]) == 0) {
+            w.shape = s;
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool parseCase(const std::string& spec, FuzzCase& c, std::string& error) {
+    std::vector<std::string> tokens;
+    size_t pos = 0;
+    while (pos < spec.size()) {
+        size_t end = spec.find(' ', pos);
+        if (end == std::string::npos) end = spec.size();
+        if (end > pos) tokens.push_back(spec.substr(pos, end - pos));
+        pos = end + 1;
+    }
+    if (tokens.empty()) {
+        error = "empty spec";
+        return false;
+    }
+    
+    c = FuzzCase();
+    c.kernel = -1;
+    for (int k = 0; k < kNumKernels; k++) {
+        if (tokens[0] == kKernels[k].name) c.kernel = k;
+    }
+    if (c.kernel < 0) {
+        error = "unknown kernel " + tokens[0];
+        return false;
+    }
+    
+    for (size_t i = 1; i < tokens.size(); i++) {
+        const char* t = tokens[i].c_str();
+        const char* eq = strchr(t, '=');
+        bool ok = true;
+        if (t[0] == 't' && t[1] == '@') {
+            FuzzEvent e = { 0, EVENT_TRIGGER, -1, 1.0f, 0.0f };
+            ok = sscanf(t + 2, "%d:%f:%f", &e.frame, &e.a, &e.b) == 3;
+            c.events.push_back(e);
+        } else if (t[0] == 'r' && t[1] == '@') {
+            FuzzEvent e = { 0, EVENT_RAISE, -1, 1.0f, 0.0f };
+            ok = sscanf(t + 2, "%d:%f", &e.frame, &e.a) == 2;
+            c.events.push_back(e);
+        } else if (t[0] == 'p' && t[1] == '@') {
+            FuzzEvent e = { 0, EVENT_PARAM, -1, 0.0f, 0.0f };
+            const char* colon = strchr(t, ':');
+            ok = colon && eq && sscanf(t + 2, "%d", &e.frame) == 1;
+            if (ok) e.field = findField(colon + 1, (size_t)(eq - colon - 1));
+            ok = ok && e.field >= 0;
+            if (ok) e.a = (float)atof(eq + 1);
+            c.events.push_back(e);
+        } else if (!eq) {
+            ok = false;
+        } else if (strncmp(t, "n=", 2) == 0) {
+            c.length = atoi(eq + 1);
+        } else if (strncmp(t, "block=", 6) == 0) {
+            c.blockSize = atoi(eq + 1);
+        } else if (strncmp(t, "in=", 3) == 0) {
+            ok = parseWave(eq + 1, c.input);
+        } else if (strncmp(t, "led=", 4) == 0) {
+            ok = parseWave(eq + 1, c.led);
+        } else if (strncmp(t, "cv=", 3) == 0) {
+            FuzzWave cv;
+            const char* colon = strchr(eq, ':');
+            ok = colon != nullptr;
+            if (ok) cv.field = findField(eq + 1, (size_t)(colon - eq - 1));
+            ok = ok && cv.field >= 0 && parseWave(colon + 1, cv);
+            c.cvs.push_back(cv);
+        } else {
+            int f = findField(t, (size_t)(eq - t));
+            ok = f >= 0;
+            if (ok) c.settings[f] = (float)atof(eq + 1);
+        }
+        if (!ok) {
+            error = "cannot parse '" + tokens[i] + "'";
+            return false;
+        }
+    }
+    if (c.length < 1 || c.blockSize < 1) {
+        error = "n and block must be positive";
+        return false;
+    }
+    return true;
+}
+
+// ============================================================================
+// RUNNER - Both sides through the same calls, compared sample by sample
+// ============================================================================
+
+struct Divergence {
+    bool found = false;
+    int frame = -1;
+    float ref = 0.0f;
+    float opt = 0.0f;
+    float error = 0.0f;         // Distance outside the reference's range
+    float tolerance = 0.0f;
+    float maxError = 0.0f;      // Largest error seen, diverging or not
+    float maxRatio = 0.0f;      // Largest error over its tolerance (at --tolerance 1)
+};
+
+// Everything a side is told about one sample, shared by both
+struct SampleDrive {
+    float input;
+    float filterGate;       // Filter and FX kernels: the harness envelope
+    float vcaGate;
+    float led;
+};
+
+// Settings after CV, in the units the kernels take
+struct Resolved {
+    float v[kNumFields];
+};
+
+template <typename Channel>
+static void applyChannel(Channel& ch, const Resolved& r) {
+    ch.setParams(r.v[FIELD_RESONANCE], r.v[FIELD_DECAY], r.v[FIELD_OPEN], r.v[FIELD_DAMPENING],
+                 (MaterialMode)(int)r.v[FIELD_MATERIAL], (FXMode)(int)r.v[FIELD_FX],
+                 r.v[FIELD_FX_AMOUNT], r.v[FIELD_GAIN], r.v[FIELD_HIT_MEMORY] != 0.0f);
+}
+
+template <typename Channel>
+static void applyBody(Channel& ch, const Resolved& r) {
+    ch.setBody(r.v[FIELD_BODY] != 0.0f, r.v[FIELD_BODY_TUNE], r.v[FIELD_BODY_MIX]);
+}
+
+template <typename Filter>
+static void applyFilter(Filter& f, const Resolved& r) {
+    int material = (int)r.v[FIELD_MATERIAL];
+    f.setResonance(r.v[FIELD_RESONANCE] * (1.0f - r.v[FIELD_DAMPENING] * 0.4f));
+    f.setBrightness(kMaterialBrightness[material] * (1.0f - r.v[FIELD_DAMPENING] * 0.85f));
+}
+
+template <typename FX>
+static void applyFX(FX& fx, const Resolved& r) {
+    fx.setMode((FXMode)(int)r.v[FIELD_FX]);
+    fx.setAmount(r.v[FIELD_FX_AMOUNT]);
+}
+
+static Resolved resolve(const float* settings, const std::vector<FuzzWave>& cvs, int frame) {
+    Resolved r;
+    for (int f = 0; f < kNumFields; f++) {
+        r.v[f] = clampf(settings[f], kFields[f].lo, kFields[f].hi);
+        if (kFields[f].integer) r.v[f] = floorf(r.v[f] + 0.5f);
+    }
+    for (const FuzzWave& cv : cvs) {
+        r.v[cv.field] = clampf(r.v[cv.field] + waveAt(cv, frame), 0.0f, 1.0f);
+    }
+    return r;
+}
+
+// Both sides' observable, frame by frame
+struct FuzzTrace {
+    std::vector<float> ref;
+    std::vector<float> opt;
+};
+
+// Checks frames [from, to) of the trace; every frame needs the reference up
+// to `lag` frames ahead, so `to` trails the run by that much until the end.
+// With `hold` set, only the last frame of each hold is checked: that is where
+// the reference has caught up with the step the held side took at its start.
+static void compareFrames(const KernelInfo& info, int hold, float tolScale, const FuzzTrace& t, int from, int to,
+                          Divergence& d) {
+    int last = (int)t.ref.size() - 1;
+    for (int n = from; n < to && !d.found; n++) {
+        if (hold && (n + 1) % hold != 0) continue;
+        float lo = t.ref[n], hi = t.ref[n];
+        for (int m = (n > info.lag ? n - info.lag : 0); m <= n + info.lag && m <= last; m++) {
+            lo = fminf(lo, t.ref[m]);
+            hi = fmaxf(hi, t.ref[m]);
+        }
+        float opt = t.opt[n];
+        float err = (opt < lo) ? lo - opt : (opt > hi) ? opt - hi : 0.0f;
+        if (opt != opt || lo != lo || hi != hi) err = INFINITY;
+        float tolerance = (info.absTol + info.relTol * fmaxf(fabsf(lo), fabsf(hi))) * tolScale;
+        d.maxError = fmaxf(d.maxError, err);
+        d.maxRatio = fmaxf(d.maxRatio, err / (tolerance / tolScale));
+        if (err > tolerance) {
+            d.found = true;
+            d.frame = n;
+            d.ref = t.ref[n];
+            d.opt = opt;
+            d.error = err;
+            d.tolerance = tolerance;
+        }
+    }
+}
+
+// Runs the case; stops at the first divergence. If `trace` is given, it
+// keeps both sides' observable for every frame run.
+static Divergence runCase(const FuzzCase& c, float tolScale, FuzzTrace* trace = nullptr) {
+    const KernelInfo& info = kKernels[c.kernel];
+    FuzzTrace localTrace;
+    FuzzTrace& t = trace ? *trace : localTrace;
+    t.ref.clear();
+    t.opt.clear();
+    t.ref.reserve(c.length);
+    t.opt.reserve(c.length);
+    
+    LPGChannel optChannel;
+    ReferenceChannel refChannel;
+    BuchlaLPGFilter optFilter;
+    ReferenceFilter refFilter;
+    FXProcessor optFX;
+    ReferenceFX refFX;
+    
+    // Small slots, so hits also run off the end of a recorded curve
+    HitCache hitCache;
+    std::vector<HitCacheFrame> hitMemory(kHitCacheSlots * 512);
+    hitCache.init(hitMemory.data(), (uint32_t)(hitMemory.size() * sizeof(HitCacheFrame)));
+    if (c.kernel == KERNEL_CHANNEL_CACHE) optChannel.setHitCache(&hitCache);
+    
+    QualityTier tier = QUALITY_STANDARD;
+    if (c.kernel == KERNEL_CHANNEL_ECO || c.kernel == KERNEL_FILTER_ECO) tier = QUALITY_ECO;
+    if (c.kernel == KERNEL_CHANNEL_HQ) tier = QUALITY_HQ;
+    int oversampling = (c.kernel == KERNEL_FX_2X) ? 2 : 1;
+    
+    optChannel.setSampleRate(kSampleRate);
+    refChannel.setSampleRate(kSampleRate);
+    optChannel.setQuality(tier);
+    refChannel.setQuality(tier);
+    optChannel.setCVMode(c.kernel == KERNEL_CHANNEL_CV);
+    refChannel.setCVMode(c.kernel == KERNEL_CHANNEL_CV);
+    optFilter.setSampleRate(kSampleRate);
+    refFilter.setSampleRate(kSampleRate);
+    optFilter.setQuality(tier);
+    optFX.setSampleRate(kSampleRate, oversampling);
+    refFX.setSampleRate(kSampleRate, oversampling);
+    
+    float settings[kNumFields];
+    memcpy(settings, c.settings, sizeof(settings));
+    
+    // Filter and FX kernels get their gates from a plain struck envelope,
+    // with a 0.5ms attack as the vactrol would give them
+    float strike = 0.0f, envelope = 0.0f;
+    const float attackCoef = 1.0f - expf(-1.0f / (0.0005f * kSampleRate));
+    
+    // Filter Eco takes one smoothing step per hold, from the gate and
+    // settings at its first frame. Its reference is fed those same inputs,
+    // sampled and held, so the two agree at the end of every hold.
+    const int hold = info.held ? controlInterval(kEcoRateHz, kSampleRate) : 0;
+    Resolved heldFilter = Resolved();
+    float heldGate = 0.0f;
+    
+    Divergence d;
+    int checked = 0;
+    size_t nextEvent = 0;
+    const int controlFrames = controlInterval(kControlRateHz, kSampleRate);
+    float chunk[kMaxControlBlock];
+    float refChunk[kMaxControlBlock];
+    
+    for (int blockStart = 0; blockStart < c.length; blockStart += c.blockSize) {
+        int blockFrames = c.length - blockStart;
+        if (blockFrames > c.blockSize) blockFrames = c.blockSize;
+        
+        // Parameter changes made during the previous block land here
+        bool paramsChanged = (blockStart == 0);
+        for (size_t e = nextEvent; e < c.events.size() && c.events[e].frame < blockStart + blockFrames; e++) {
+            if (c.events[e].type == EVENT_PARAM && c.events[e].frame <= blockStart) {
+                settings[c.events[e].field] = c.events[e].a;
+                paramsChanged = true;
+            }
+        }
+        if (paramsChanged) {
+            Resolved r = resolve(settings, std::vector<FuzzWave>(), blockStart);
+            applyChannel(optChannel, r);
+            applyChannel(refChannel, r);
+            applyBody(optChannel, r);
+            applyBody(refChannel, r);
+            applyFilter(optFilter, r);
+            if (hold) heldFilter = r;
+            else applyFilter(refFilter, r);
+            applyFX(optFX, r);
+            applyFX(refFX, r);
+        }
+        Resolved base = resolve(settings, std::vector<FuzzWave>(), blockStart);
+        float decayMs = 5.0f + base.v[FIELD_DECAY] * 2000.0f;
+        float envelopeCoef = expf(-6.9078f / (decayMs * 0.001f * kSampleRate));
+        
+        for (int chunkStart = 0; chunkStart < blockFrames; chunkStart += controlFrames) {
+            int chunkFrames = blockFrames - chunkStart;
+            if (chunkFrames > controlFrames) chunkFrames = controlFrames;
+            
+            // CV, as the plugin samples it: once per chunk of the block
+            if (!c.cvs.empty()) {
+                Resolved r = resolve(settings, c.cvs, blockStart + chunkStart);
+                applyChannel(optChannel, r);
+                applyChannel(refChannel, r);
+                applyFilter(optFilter, r);
+                if (hold) heldFilter = r;
+                else applyFilter(refFilter, r);
+                applyFX(optFX, r);
+                applyFX(refFX, r);
+            }
+            
+            for (int j = 0; j < chunkFrames; j++) {
+                int n = blockStart + chunkStart + j;
+                while (nextEvent < c.events.size() && c.events[nextEvent].frame <= n) {
+                    const FuzzEvent& e = c.events[nextEvent++];
+                    if (e.type == EVENT_TRIGGER) {
+                        optChannel.trigger(e.a, e.b);
+                        refChannel.trigger(e.a, e.b);
+                        optFilter.dampStateOnRetrigger();
+                        refFilter.dampStateOnRetrigger();
+                        strike = e.a;
+                    } else if (e.type == EVENT_RAISE) {
+                        optChannel.raiseVelocity(e.a);
+                        refChannel.raiseVelocity(e.a);
+                        strike = fmaxf(strike, e.a);
+                    }
+                }
+                
+                SampleDrive s;
+                s.input = waveAt(c.input, n);
+                envelope += (strike - envelope) * attackCoef;
+                s.filterGate = powf(envelope, 1.8f);
+                s.vcaGate = sqrtf(envelope);
+                s.led = fabsf(waveAt(c.led, n));
+                strike *= envelopeCoef;
+                
+                if (isChannelKernel(c.kernel)) {
+                    optChannel.setLED(s.led);
+                    refChannel.setLED(s.led);
+                    chunk[j] = optChannel.process(s.input);
+                    refChunk[j] = refChannel.process(s.input);
+                    if (info.observe == OBSERVE_GATE) {
+                        chunk[j] = optChannel.getGateValue();
+                        refChunk[j] = refChannel.getGateValue();
+                    }
+                } else if (isFilterKernel(c.kernel)) {
+                    float refGate = s.filterGate;
+                    if (hold) {
+                        if (n % hold == 0) {
+                            applyFilter(refFilter, heldFilter);
+                            heldGate = s.filterGate;
+                        }
+                        refGate = heldGate;
+                    }
+                    chunk[j] = optFilter.process(s.input, s.filterGate, s.vcaGate);
+                    refChunk[j] = refFilter.process(s.input, refGate, s.vcaGate);
+                    if (info.observe == OBSERVE_CUTOFF) {
+                        chunk[j] = optFilter.getCutoff();
+                        refChunk[j] = refFilter.getCutoff();
+                    }
+                } else {
+                    float x = s.input * s.vcaGate;
+                    chunk[j] = optFX.process(x, s.vcaGate);
+                    refChunk[j] = refFX.process(x, s.vcaGate);
+                }
+            }
+            
+            if (isChannelKernel(c.kernel)) optChannel.recoverChunk(chunk, chunkFrames);
+            else if (isFilterKernel(c.kernel)) optFilter.recoverIfInvalid();
+            
+            t.ref.insert(t.ref.end(), refChunk, refChunk + chunkFrames);
+            t.opt.insert(t.opt.end(), chunk, chunk + chunkFrames);
+            int checkable = (int)t.ref.size() - info.lag;
+            if (checkable > checked) {
+                compareFrames(info, hold, tolScale, t, checked, checkable, d);
+                checked = checkable;
+            }
+            if (d.found) return d;
+        }
+    }
+    // The last `lag` frames have no reference ahead of them to compare with
+    compareFrames(info, hold, tolScale, t, checked, c.length - info.lag, d);
+    return d;
+}
+
+// ============================================================================
+// REDUCTION - Smallest case that still diverges
+//
+// Greedy: try each simplification, keep it if the case still diverges,
+// and repeat until a full pass changes nothing. Every kept step shortens
+// the case to its new divergence point.
+// ============================================================================
+
+static bool stillFails(const FuzzCase& candidate, float tolScale, FuzzCase& best, Divergence& d) {
+    Divergence trial = runCase(candidate, tolScale);
+    if (!trial.found) return false;
+    best = candidate;
+    best.length = std::min(trial.frame + 1 + kKernels[candidate.kernel].lag, candidate.length);
+    d = trial;
+    return true;
+}
+
+static FuzzCase reduceCase(const FuzzCase& failing, float tolScale, Divergence& d, int& steps) {
+    FuzzCase best = failing;
+    best.length = std::min(d.frame + 1 + kKernels[failing.kernel].lag, failing.length);
+    steps = 0;
+    
+    bool changed = true;
+    while (changed) {
+        changed = false;
+        
+        // Drop events past the end, then each remaining one
+        while (!best.events.empty() && best.events.back().frame >= best.length) best.events.pop_back();
+        for (size_t i = best.events.size(); i-- > 0;) {
+            FuzzCase candidate = best;
+            candidate.events.erase(candidate.events.begin() + (long)i);
+            if (stillFails(candidate, tolScale, best, d)) changed = true, steps++;
+        }
+        
+        for (size_t i = best.cvs.size(); i-- > 0;) {
+            FuzzCase candidate = best;
+            candidate.cvs.erase(candidate.cvs.begin() + (long)i);
+            if (stillFails(candidate, tolScale, best, d)) changed = true, steps++;
+        }
+        
+        for (int f = 0; f < kNumFields; f++) {
+            if (best.settings[f] == kFields[f].def) continue;
+            FuzzCase candidate = best;
+            candidate.settings[f] = kFields[f].def;
+            if (stillFails(candidate, tolScale, best, d)) changed = true, steps++;
+        }
+        
+        // Simpler signals: silence, then a plain sine at 1V
+        FuzzWave kSimpleInputs[2];
+        kSimpleInputs[1].shape = WAVE_SINE;
+        kSimpleInputs[1].rate = 440.0f;
+        kSimpleInputs[1].depth = 1.0f;
+        for (const FuzzWave& simple : kSimpleInputs) {
+            if (best.input.shape == simple.shape && best.input.rate == simple.rate &&
+                best.input.depth == simple.depth) break;
+            FuzzCase candidate = best;
+            candidate.input = simple;
+            if (stillFails(candidate, tolScale, best, d)) {
+                changed = true, steps++;
+                break;
+            }
+        }
+        if (best.led.shape != WAVE_NONE && best.led.shape != WAVE_SQUARE) {
+            FuzzCase candidate = best;
+            candidate.led.shape = WAVE_SQUARE;
+            if (stillFails(candidate, tolScale, best, d)) changed = true, steps++;
+        }
+        
+        // One control block per plugin block
+        int controlFrames = controlInterval(kControlRateHz, kSampleRate);
+        if (best.blockSize != controlFrames) {
+            FuzzCase candidate = best;
+            candidate.blockSize = controlFrames;
+            if (stillFails(candidate, tolScale, best, d)) changed = true, steps++;
+        }
+    }
+    return best;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static void usage() {
+    fprintf(stderr,
+        "usage: hmfuzz [--cases n] [--seed n] [--kernel name]... [--max-length n]\n"
+        "              [--tolerance x] [--case \"<spec>\"] [--list]\n");
+}
+
+static void printDivergence(const FuzzCase& c, const Divergence& d) {
+    const KernelInfo& info = kKernels[c.kernel];
+    printf("  first divergence at frame %d: %s ref %.9g, opt %.9g (error %.3g, tolerance %.3g",
+           d.frame, kObservableNames[info.observe], d.ref, d.opt, d.error, d.tolerance);
+    if (info.lag > 0) printf(" over +-%d frames", info.lag);
+    if (info.held) printf(" at the end of a hold");
+    printf(")\n");
+}
+
+static int runSingle(const std::string& spec, float tolScale) {
+    FuzzCase c;
+    std::string error;
+    if (!parseCase(spec, c, error)) {
+        fprintf(stderr, "hmfuzz: %s\n", error.c_str());
+        return 1;
+    }
+    FuzzTrace trace;
+    Divergence d = runCase(c, tolScale, &trace);
+    printf("%s\n", formatCase(c).c_str());
+    if (!d.found) {
+        printf("  no divergence over %d frames (max error %.3g)\n", c.length, d.maxError);
+        return 0;
+    }
+    printDivergence(c, d);
+    int from = d.frame > 8 ? d.frame - 8 : 0;
+    int to = std::min(d.frame + 8, (int)trace.ref.size() - 1);
+    printf("  %8s %16s %16s %12s\n", "frame", "ref", "opt", "diff");
+    for (int n = from; n <= to; n++) {
+        float ref = trace.ref[n], opt = trace.opt[n];
+        printf("  %8d %16.9g %16.9g %12.3g%s\n", n, ref, opt, opt - ref, n == d.frame ? "  <" : "");
+    }
+    return 1;
+}
+
+int main(int argc, char** argv) {
+    int numCases = 300;
+    uint32_t firstSeed = 1;
+    int maxLength = 24000;
+    float tolScale = 1.0f;
+    bool selected[kNumKernels] = {};
+    bool anySelected = false;
+    std::string single;
+    
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        bool hasValue = a + 1 < argc;
+        if (arg == "--cases" && hasValue) {
+            numCases = atoi(argv[++a]);
+        } else if (arg == "--seed" && hasValue) {
+            firstSeed = (uint32_t)strtoul(argv[++a], nullptr, 10);
+        } else if (arg == "--max-length" && hasValue) {
+            maxLength = atoi(argv[++a]);
+        } else if (arg == "--tolerance" && hasValue) {
+            tolScale = (float)atof(argv[++a]);
+        } else if (arg == "--case" && hasValue) {
+            single = argv[++a];
+        } else if (arg == "--kernel" && hasValue) {
+            std::string name = argv[++a];
+            int k = 0;
+            while (k < kNumKernels && name != kKernels[k].name) k++;
+            if (k == kNumKernels) {
+                fprintf(stderr, "hmfuzz: unknown kernel %s (see --list)\n", name.c_str());
+                return 1;
+            }
+            selected[k] = anySelected = true;
+        } else if (arg == "--list") {
+            for (int k = 0; k < kNumKernels; k++) {
+                const KernelInfo& info = kKernels[k];
+                printf("%-13s %-7s lag %-3d %-4s abs %-8.3g rel %-8.3g %s\n", info.name,
+                       kObservableNames[info.observe], info.lag, info.held ? "held" : "", info.absTol,
+                       info.relTol, info.what);
+            }
+            return 0;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (maxLength < 256) maxLength = 256;
+    
+    // Same denormal handling as step()
+    FlushDenormalsScope flushDenormals;
+    
+    if (!single.empty()) return runSingle(single, tolScale);
+    
+    int failures = 0;
+    for (int k = 0; k < kNumKernels; k++) {
+        if (anySelected && !selected[k]) continue;
+        float worst = 0.0f, worstRatio = 0.0f;
+        long frames = 0;
+        int passed = 0;
+        for (int i = 0; i < numCases; i++) {
+            uint32_t seed = firstSeed + (uint32_t)i;
+            FuzzCase c = generateCase(k, seed, maxLength);
+            Divergence d = runCase(c, tolScale);
+            worst = fmaxf(worst, d.maxError);
+            worstRatio = fmaxf(worstRatio, d.maxRatio);
+            if (!d.found) {
+                passed++;
+                frames += c.length;
+                continue;
+            }
+            
+            failures++;
+            printf("%-13s FAIL at seed %u after %d passing cases\n", kKernels[k].name, seed, passed);
+            printf("  case:    %s\n", formatCase(c).c_str());
+            printDivergence(c, d);
+            int steps;
+            FuzzCase reduced = reduceCase(c, tolScale, d, steps);
+            printf("  reduced in %d steps to:\n", steps);
+            printf("  hmfuzz --case \"%s\"\n", formatCase(reduced).c_str());
+            printDivergence(reduced, d);
+            break;
+        }
+        if (passed == numCases) {
+            printf("%-13s ok   %d cases, %ld frames, max error %.3g (%.2f of tolerance)\n", kKernels[k].name,
+                   passed, frames, worst, worstRatio);
+        }
+    }
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,1140 @@
+/*
+ * hmhost - Holy Mackerel host harness
+ *
+ * Builds the plugin source natively and drives it through ntHost with a
+ * synthetic patch, so DSP behaviour and diagnostics can be inspected
+ * without a module:
+ *
+ *   bus 1      saw 110Hz + noise        (Left Input default)
+ *   bus 2      saw 165Hz                (Right Input default)
+ *   bus 3      5V trigger pulses        (Trigger Input default)
+ *   bus 4-8    slow LFOs, ±2.5V         (patch with e.g. -p "Decay CV=4")
+ *   bus 13/14  outputs
+ *
+ * Usage: hmhost <command> [options]
+ *
+ * Commands:
+ *   profile    run the patch and print the per-stage timing table
+ *              (needs HM_PROFILE=1, which the host Makefile sets)
+ *   health     run the patch and print the DSP health counters
+ *   trace      arm the state trace, capture the window around the next
+ *              trigger and write it as CSV (or binary with --binary)
+ *   capture    run the patch with bus capture on and write the stream
+ *   replay <f> replay a capture block-for-block, check every output hash
+ *              and report the speed relative to real time
+ *   freqresp   check the SVF prewarp: fast_tan against tan, then the
+ *              measured resonant peak against the aimed cutoff, every tier
+ *   analyze    hold an LPGChannel at a fixed gate and drive it with a
+ *              stepped sine sweep and a multitone; per Material x FX x
+ *              Resonance and tier, print THD+N, alias energy, multitone
+ *              distortion, response error against HQ and cost per sample
+ *   srcheck    render one strike per scenario (materials, tiers, FX, body,
+ *              CV gate, Decay CV) at 44.1, 48, 96 and 192kHz and check
+ *              decay times, levels and brightness against 48kHz; prints
+ *              the step() cost per second of audio at each rate
+ *
+ * Options:
+ *   --sr <hz>          sample rate (default 48000)
+ *   --block <frames>   frames per step(), multiple of 4 (default 32)
+ *   --seconds <s>      length of the run (default 10)
+ *   --trig-ms <ms>     trigger interval, 0 = no triggers (default 250)
+ *   --gate-ms <ms>     length of each bus 3 pulse (default 5), e.g. longer
+ *                      gates for Trig Source=CV
+ *   --hits             make bus 1 percussive: the saw decays over ~80ms from
+ *                      each trigger, peaks cycling 5/3.5/2V (for Trig Source=Audio)
+ *   --midi-ms <ms>     also send a MIDI note-on (channel 1, note 60, velocity
+ *                      cycling 127/96/64/32) at this interval, before the
+ *                      block it falls in (default 0 = none)
+ *   -p <Name=value>    set a parameter by display name, e.g. -p "FX=3"
+ *   -a <Name=value@s>  change a parameter s seconds into the run
+ *   --screen           print the text draw() produced at the end of the run
+ *   --out <file>       trace/capture output file (trace default: stdout CSV);
+ *                      replay writes the output buses here as raw float32 L/R
+ *   --binary           trace: write the binary format instead of CSV
+ *   --trace-at <s>     trace: arm at this time into the run (default 0)
+ *   --trace-decim <n>  trace: record every n-th sample (default HM_TRACE_DECIMATION)
+ *   --level <V>        analyze: input amplitude in volts (default 0.5)
+ *   --gate <0-1>       analyze: vactrol level held during the run (default 0.6)
+ *   --fx-amount <pct>  analyze: FX Amount for the Tube/Screamer/Grit rows (default 70)
+ *                      (--out writes the table as CSV as well)
+ *
+ * Binary trace format (little endian):
+ *   char[4] "HMTR", uint32 version (1), uint32 numFields, uint32 numFrames,
+ *   int32 triggerIndex, float sampleRate, uint32 decimation,
+ *   then numFrames × numFields float32, oldest first, fields as the CSV header.
+ */
+
+#include "../holyMackerel.cpp"
+#include "ntHost.h"
+
+#include <stdlib.h>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+#include <chrono>
+#include <complex>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+// ============================================================================
+// TEST PATCH
+// ============================================================================
+
+struct Automation {
+    std::string name;
+    int value;
+    float atSeconds;
+};
+
+struct PatchOptions {
+    uint32_t sampleRate = 48000;
+    int blockFrames = 32;
+    float seconds = 10.0f;
+    float trigIntervalMs = 250.0f;
+    float gateMs = 5.0f;
+    float midiIntervalMs = 0.0f;
+    bool audioHits = false;
+    bool screen = false;
+    std::vector<std::pair<std::string, int>> params;
+    std::vector<Automation> automation;
+    std::string outPath;
+    std::string inPath;
+    bool binary = false;
+    float traceAtSeconds = 0.0f;
+    int traceDecimation = 0;
+    float analysisLevel = 0.5f;
+    float analysisGate = 0.6f;
+    float analysisFXAmount = 0.7f;
+};
+
+class TestPatch {
+public:
+    explicit TestPatch(const PatchOptions& opts) : opts(opts) {
+        trigPeriod = (int)(opts.trigIntervalMs * 0.001f * opts.sampleRate);
+        pulseLength = (int)(opts.gateMs * 0.001f * opts.sampleRate);
+        hitDecay = expf(-1.0f / (0.08f * opts.sampleRate));
+    }
+    
+    // Fill the input buses for one block; outputs are cleared
+    void fill(float* bus, int numFrames) {
+        const float sr = (float)opts.sampleRate;
+        for (int i = 0; i < numFrames; i++) {
+            long n = frame + i;
+            seed = seed * 1664525u + 1013904223u;
+            float noise = (float)(seed >> 8) / 16777216.0f * 2.0f - 1.0f;
+            
+            phaseL += 110.0f / sr;
+            if (phaseL >= 1.0f) phaseL -= 1.0f;
+            phaseR += 164.8f / sr;
+            if (phaseR >= 1.0f) phaseR -= 1.0f;
+            
+            float levelL = 4.0f;
+            if (opts.audioHits) {
+                static const float kHitPeaks[3] = { 5.0f, 3.5f, 2.0f };
+                if (trigPeriod > 0 && n % trigPeriod == 0) hitEnv = kHitPeaks[(n / trigPeriod) % 3];
+                levelL = hitEnv;
+                hitEnv *= hitDecay;
+            }
+            bus[0 * numFrames + i] = (2.0f * phaseL - 1.0f) * levelL + noise * 0.2f;
+            bus[1 * numFrames + i] = (2.0f * phaseR - 1.0f) * 4.0f;
+            
+            bool high = trigPeriod > 0 && (n % trigPeriod) < pulseLength;
+            bus[2 * numFrames + i] = high ? 5.0f + noise * 0.05f : noise * 0.01f;
+            
+            for (int c = 0; c < 5; c++) {
+                float rate = 0.13f + 0.11f * c;
+                bus[(3 + c) * numFrames + i] = 2.5f * sinf(TWO_PI * rate * (float)n / sr);
+            }
+        }
+        for (int b = 8; b < kNtHostNumBusses; b++) {
+            memset(bus + b * numFrames, 0, numFrames * sizeof(float));
+        }
+        frame += numFrames;
+    }
+    
+private:
+    const PatchOptions& opts;
+    long frame = 0;
+    uint32_t seed = 12345;
+    float phaseL = 0.0f, phaseR = 0.0f;
+    int trigPeriod = 0;
+    int pulseLength = 0;
+    float hitEnv = 0.0f;
+    float hitDecay = 1.0f;
+};
+
+static bool createInstance(NtHostInstance& inst, const PatchOptions& opts, bool keepCapture = false) {
+    ntHostSetSampleRate(opts.sampleRate);
+    ntHostSetMaxFramesPerStep(opts.blockFrames);
+    const _NT_factory* factory = (const _NT_factory*)pluginEntry(kNT_selector_factoryInfo, 0);
+    if (!ntHostCreate(inst, factory)) {
+        fprintf(stderr, "construct failed\n");
+        return false;
+    }
+    for (const auto& p : opts.params) {
+        int index = ntHostFindParameter(inst, p.first.c_str());
+        if (index < 0) {
+            fprintf(stderr, "unknown parameter '%s'\n", p.first.c_str());
+            return false;
+        }
+        ntHostSetParameter(inst, index, (int16_t)p.second);
+    }
+#if HM_CAPTURE
+    // Construct starts a capture, as on the module; only 'capture' wants it
+    if (!keepCapture) ((_holyMackerelAlgorithm*)inst.alg)->capture.stop();
+#endif
+    for (const Automation& a : opts.automation) {
+        if (ntHostFindParameter(inst, a.name.c_str()) < 0) {
+            fprintf(stderr, "unknown parameter '%s'\n", a.name.c_str());
+            return false;
+        }
+    }
+    return true;
+}
+
+// Run the patch for opts.seconds; returns the number of blocks processed.
+// beforeBlock, if given, runs ahead of each step() with the block index.
+static long runPatch(NtHostInstance& inst, const PatchOptions& opts,
+                     std::function<void(long)> beforeBlock = nullptr) {
+    std::vector<float> bus(kNtHostNumBusses * opts.blockFrames);
+    TestPatch patch(opts);
+    long numBlocks = (long)(opts.seconds * opts.sampleRate) / opts.blockFrames;
+    long midiPeriod = (long)(opts.midiIntervalMs * 0.001f * opts.sampleRate);
+    long nextMidi = 0;
+    int numMidi = 0;
+    static const uint8_t kMidiVelocities[4] = { 127, 96, 64, 32 };
+    for (long b = 0; b < numBlocks; b++) {
+        patch.fill(bus.data(), opts.blockFrames);
+        // The module delivers MIDI between blocks, so notes land on block starts
+        while (midiPeriod > 0 && nextMidi < (b + 1) * opts.blockFrames) {
+            inst.factory->midiMessage(inst.alg, 0x90, 60, kMidiVelocities[numMidi++ & 3]);
+            nextMidi += midiPeriod;
+        }
+        for (const Automation& a : opts.automation) {
+            if ((long)(a.atSeconds * opts.sampleRate) / opts.blockFrames == b) {
+                ntHostSetParameter(inst, ntHostFindParameter(inst, a.name.c_str()), (int16_t)a.value);
+            }
+        }
+        if (beforeBlock) beforeBlock(b);
+        ntHostStep(inst, bus.data(), opts.blockFrames);
+    }
+    return numBlocks;
+}
+
+static void showScreen(NtHostInstance& inst) {
+    ntHostClearScreen();
+    inst.factory->draw(inst.alg);
+    ntHostDumpScreen(stdout);
+}
+
+// ============================================================================
+// COMMANDS
+// ============================================================================
+
+static int cmdProfile(const PatchOptions& opts) {
+#if HM_PROFILE
+    NtHostInstance inst;
+    if (!createInstance(inst, opts)) return 1;
+    long numBlocks = runPatch(inst, opts);
+    
+    static const char* const rowNames[StageProfiler::kNumRows] = {
+        "trigger", "cv", "envelope", "filter", "body", "fx", "output", "step"
+    };
+    _holyMackerelAlgorithm* alg = (_holyMackerelAlgorithm*)inst.alg;
+    const StageProfiler& prof = alg->profiler;
+    float budget = kProfTicksPerSecond / alg->sampleRate;
+    
+    printf("%ld blocks of %d frames at %u Hz\n", numBlocks, opts.blockFrames, opts.sampleRate);
+    printf("%-10s %10s %10s %10s %9s\n", "stage", "min", "avg", "max", "budget%");
+    for (int row = 0; row < StageProfiler::kNumRows; row++) {
+        printf("%-10s %10.1f %10.1f %10.1f %8.2f%%\n", rowNames[row],
+               prof.getMin(row), prof.getAvg(row), prof.getMax(row),
+               100.0f * prof.getAvg(row) / budget);
+    }
+    printf("(%s per sample; budget = %.0f %s per sample)\n", kProfTickUnit, budget, kProfTickUnit);
+    
+    if (opts.screen) showScreen(inst);
+    return 0;
+#else
+    fprintf(stderr, "profile: hmhost was built without HM_PROFILE=1\n");
+    return 1;
+#endif
+}
+
+static int cmdHealth(const PatchOptions& opts) {
+#if HM_HEALTH
+    NtHostInstance inst;
+    if (!createInstance(inst, opts)) return 1;
+    long numBlocks = runPatch(inst, opts);
+    
+    _holyMackerelAlgorithm* alg = (_holyMackerelAlgorithm*)inst.alg;
+    HealthCounters h;
+    collectHealth(alg, h);
+    
+    float seconds = (float)(numBlocks * opts.blockFrames) / (float)opts.sampleRate;
+    printf("%ld blocks of %d frames at %u Hz (%.1fs)\n", numBlocks, opts.blockFrames, opts.sampleRate, seconds);
+    printf("%-14s %10s %10s\n", "event", "count", "per min");
+    for (int e = 0; e < kNumHealthEvents; e++) {
+        printf("%-14s %10lu %10.1f\n", healthEventNames[e], (unsigned long)h.count[e],
+               60.0f * (float)h.count[e] / seconds);
+    }
+    
+    if (opts.screen) showScreen(inst);
+    return 0;
+#else
+    fprintf(stderr, "health: hmhost was built with HM_HEALTH=0\n");
+    return 1;
+#endif
+}
+
+static int cmdTrace(const PatchOptions& opts) {
+#if HM_TRACE
+    NtHostInstance inst;
+    if (!createInstance(inst, opts)) return 1;
+    _holyMackerelAlgorithm* alg = (_holyMackerelAlgorithm*)inst.alg;
+    StateTrace& trace = alg->trace;
+    if (opts.traceDecimation > 0) trace.setDecimation(opts.traceDecimation);
+    
+    long armBlock = (long)(opts.traceAtSeconds * opts.sampleRate) / opts.blockFrames;
+    runPatch(inst, opts, [&](long block) {
+        if (block == armBlock) trace.arm();
+    });
+    
+    if (trace.getState() != TRACE_DONE) {
+        fprintf(stderr, "trace: window not complete (state %d) - run longer or arm earlier\n",
+                (int)trace.getState());
+        return 1;
+    }
+    
+    FILE* out = stdout;
+    if (!opts.outPath.empty()) {
+        out = fopen(opts.outPath.c_str(), opts.binary ? "wb" : "w");
+        if (!out) {
+            fprintf(stderr, "trace: cannot open %s\n", opts.outPath.c_str());
+            return 1;
+        }
+    }
+    
+    int numFrames = trace.getNumFrames();
+    int trig = trace.getTriggerIndex();
+    if (opts.binary) {
+        uint32_t header[3] = { 1, kNumTraceFields, (uint32_t)numFrames };
+        int32_t trigIndex = trig;
+        float sr = alg->sampleRate;
+        uint32_t decimation = (uint32_t)trace.getDecimation();
+        fwrite("HMTR", 1, 4, out);
+        fwrite(header, sizeof(uint32_t), 3, out);
+        fwrite(&trigIndex, sizeof(trigIndex), 1, out);
+        fwrite(&sr, sizeof(sr), 1, out);
+        fwrite(&decimation, sizeof(decimation), 1, out);
+        for (int i = 0; i < numFrames; i++) {
+            fwrite(trace.getFrame(i).v, sizeof(float), kNumTraceFields, out);
+        }
+    } else {
+        float msPerFrame = 1000.0f * trace.getDecimation() / alg->sampleRate;
+        fprintf(out, "time_ms");
+        for (int f = 0; f < kNumTraceFields; f++) fprintf(out, ",%s", traceFieldNames[f]);
+        fprintf(out, "\n");
+        for (int i = 0; i < numFrames; i++) {
+            const TraceFrame& frame = trace.getFrame(i);
+            fprintf(out, "%.4f", (float)(i - trig) * msPerFrame);
+            for (int f = 0; f < kNumTraceFields; f++) fprintf(out, ",%.9g", frame.v[f]);
+            fprintf(out, "\n");
+        }
+    }
+    if (out != stdout) fclose(out);
+    
+    if (opts.screen) showScreen(inst);
+    return 0;
+#else
+    fprintf(stderr, "trace: hmhost was built without HM_TRACE=1\n");
+    return 1;
+#endif
+}
+
+static int cmdCapture(const PatchOptions& opts) {
+#if HM_CAPTURE
+    if (opts.outPath.empty()) {
+        fprintf(stderr, "capture: --out <file> required\n");
+        return 1;
+    }
+    NtHostInstance inst;
+    if (!createInstance(inst, opts, true)) return 1;
+    runPatch(inst, opts);
+    
+    const BusCapture& cap = ((_holyMackerelAlgorithm*)inst.alg)->capture;
+    FILE* out = fopen(opts.outPath.c_str(), "wb");
+    if (!out) {
+        fprintf(stderr, "capture: cannot open %s\n", opts.outPath.c_str());
+        return 1;
+    }
+    fwrite(cap.getData(), 1, cap.getBytesUsed(), out);
+    fclose(out);
+    
+    printf("%lu blocks, %lu bytes%s\n", (unsigned long)cap.getNumBlocks(),
+           (unsigned long)cap.getBytesUsed(), cap.isRecording() ? "" : " (buffer full)");
+    if (cap.getDroppedEvents()) {
+        printf("warning: %lu parameter/MIDI events dropped\n", (unsigned long)cap.getDroppedEvents());
+    }
+    return 0;
+#else
+    fprintf(stderr, "capture: hmhost was built without HM_CAPTURE=1\n");
+    return 1;
+#endif
+}
+
+// Bounds-checked reader over a capture stream
+class CaptureReader {
+public:
+    CaptureReader(const std::vector<uint8_t>& data) : data(data) {}
+    bool read(void* dst, size_t n) {
+        if (pos + n > data.size()) return false;
+        memcpy(dst, data.data() + pos, n);
+        pos += n;
+        return true;
+    }
+    bool atEnd() const { return pos >= data.size(); }
+private:
+    const std::vector<uint8_t>& data;
+    size_t pos = 0;
+};
+
+static int cmdReplay(const PatchOptions& opts) {
+    FILE* in = fopen(opts.inPath.c_str(), "rb");
+    if (!in) {
+        fprintf(stderr, "replay: cannot open %s\n", opts.inPath.c_str());
+        return 1;
+    }
+    std::vector<uint8_t> data;
+    uint8_t chunk[65536];
+    size_t n;
+    while ((n = fread(chunk, 1, sizeof(chunk), in)) > 0) data.insert(data.end(), chunk, chunk + n);
+    fclose(in);
+    
+    CaptureReader reader(data);
+    char magic[4];
+    uint16_t version, numParams;
+    float sampleRate;
+    if (!reader.read(magic, 4) || memcmp(magic, "HMCP", 4) != 0 ||
+        !reader.read(&version, 2) || version < 1 || version > kCaptureVersion ||
+        !reader.read(&numParams, 2) || !reader.read(&sampleRate, 4)) {
+        fprintf(stderr, "replay: not a version 1-%u capture\n", kCaptureVersion);
+        return 1;
+    }
+    std::vector<int16_t> snapshot(numParams);
+    if (!reader.read(snapshot.data(), 2 * numParams)) {
+        fprintf(stderr, "replay: truncated header\n");
+        return 1;
+    }
+    
+    PatchOptions replayOpts;
+    replayOpts.sampleRate = (uint32_t)sampleRate;
+    NtHostInstance inst;
+    if (!createInstance(inst, replayOpts)) return 1;
+    if (numParams != inst.req.numParameters) {
+        fprintf(stderr, "replay: capture has %u parameters, plugin has %u\n",
+                numParams, (unsigned)inst.req.numParameters);
+        return 1;
+    }
+    // The snapshot is what v held at capture start - apply it verbatim
+    for (int p = 0; p < numParams; p++) inst.values[p] = snapshot[p];
+    for (int p = 0; p < numParams; p++) inst.factory->parameterChanged(inst.alg, p);
+    
+    FILE* out = nullptr;
+    if (!opts.outPath.empty()) {
+        out = fopen(opts.outPath.c_str(), "wb");
+        if (!out) {
+            fprintf(stderr, "replay: cannot open %s\n", opts.outPath.c_str());
+            return 1;
+        }
+    }
+    
+    std::vector<float> bus;
+    std::vector<float> roleData;
+    std::vector<float> interleaved;
+    long numBlocks = 0, numFrames = 0, numParamChanges = 0, numMidi = 0, mismatches = 0, firstMismatch = -1;
+    double stepSeconds = 0.0;
+    bool stepped = false;
+    int lastFrames = 0;
+    const int16_t* v = inst.values.data();
+    
+    while (!reader.atEnd()) {
+        uint8_t tag;
+        if (!reader.read(&tag, 1)) break;
+        if (tag == CAPTURE_PARAM) {
+            uint16_t p;
+            int16_t value;
+            if (!reader.read(&p, 2) || !reader.read(&value, 2) || p >= numParams) break;
+            inst.values[p] = value;
+            inst.factory->parameterChanged(inst.alg, p);
+            numParamChanges++;
+        } else if (tag == CAPTURE_MIDI) {
+            uint8_t msg[3];
+            if (!reader.read(msg, 3)) break;
+            inst.factory->midiMessage(inst.alg, msg[0], msg[1], msg[2]);
+            numMidi++;
+        } else if (tag == CAPTURE_BLOCK) {
+            uint16_t frames, mask;
+            if (!reader.read(&frames, 2) || !reader.read(&mask, 2)) break;
+            bus.assign(kNtHostNumBusses * frames, 0.0f);
+            roleData.resize(frames);
+            // Where each role lives, from the parameters in force now
+            int roleBus[kNumCaptureRoles] = {
+                v[kParamLeftInput], v[kParamRightInput], v[kParamTriggerInput],
+                v[kParamResonanceCV], v[kParamDecayCV], v[kParamOpenCV],
+                v[kParamDampeningCV], v[kParamFXAmountCV],
+                v[kParamLeftOutput], v[kParamRightOutput],
+                v[kParamHighpassOutput], v[kParamBandpassOutput],
+                v[kParamFilterGateOutput], v[kParamVCAGateOutput]
+            };
+            bool ok = true;
+            for (int r = 0; r < kNumCaptureRoles && ok; r++) {
+                if (!(mask & (1u << r))) continue;
+                ok = reader.read(roleData.data(), frames * sizeof(float));
+                if (ok && roleBus[r] >= 1 && roleBus[r] <= kNtHostNumBusses) {
+                    memcpy(&bus[(roleBus[r] - 1) * frames], roleData.data(), frames * sizeof(float));
+                }
+            }
+            if (!ok) break;
+            
+            auto t0 = std::chrono::steady_clock::now();
+            ntHostStep(inst, bus.data(), frames);
+            stepSeconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            stepped = true;
+            lastFrames = frames;
+            numBlocks++;
+            numFrames += frames;
+            
+            if (out) {
+                const float* l = &bus[(v[kParamLeftOutput] - 1) * frames];
+                const float* r = (v[kParamStereo] == 1) ? &bus[(v[kParamRightOutput] - 1) * frames] : nullptr;
+                interleaved.resize(2 * frames);
+                for (int i = 0; i < frames; i++) {
+                    interleaved[2 * i] = l[i];
+                    interleaved[2 * i + 1] = r ? r[i] : 0.0f;
+                }
+                fwrite(interleaved.data(), sizeof(float), 2 * frames, out);
+            }
+        } else if (tag == CAPTURE_HASH) {
+            uint32_t expected;
+            if (!reader.read(&expected, 4) || !stepped) break;
+            stepped = false;
+            // Same buses step() hashed on the capture side
+            int frames = lastFrames;
+            bool stereo = (v[kParamStereo] == 1);
+            bool envOn = (v[kParamEnvFollower] == 1) && v[kParamEnvOutput] > 0;
+            uint32_t hash = captureHash(kCaptureHashSeed, &bus[(v[kParamLeftOutput] - 1) * frames], frames);
+            if (stereo) hash = captureHash(hash, &bus[(v[kParamRightOutput] - 1) * frames], frames);
+            if (envOn) hash = captureHash(hash, &bus[(v[kParamEnvOutput] - 1) * frames], frames);
+            const int taps[] = { kParamHighpassOutput, kParamBandpassOutput, kParamFilterGateOutput, kParamVCAGateOutput };
+            for (int tap : taps) {
+                if (v[tap] > 0) hash = captureHash(hash, &bus[(v[tap] - 1) * frames], frames);
+            }
+            if (hash != expected) {
+                if (firstMismatch < 0) firstMismatch = numBlocks - 1;
+                mismatches++;
+            }
+        } else {
+            fprintf(stderr, "replay: unknown record 0x%02x\n", tag);
+            break;
+        }
+    }
+    if (out) fclose(out);
+    if (!reader.atEnd()) {
+        fprintf(stderr, "replay: stream ended early after block %ld\n", numBlocks);
+    }
+    
+    double audioSeconds = (double)numFrames / sampleRate;
+    printf("%ld blocks (%.2fs audio at %.0f Hz), %ld parameter changes, %ld MIDI messages\n",
+           numBlocks, audioSeconds, sampleRate, numParamChanges, numMidi);
+    printf("step() time %.3fs = %.1fx real time\n", stepSeconds,
+           stepSeconds > 0.0 ? audioSeconds / stepSeconds : 0.0);
+    if (mismatches) {
+        printf("output differs in %ld blocks, first at block %ld\n", mismatches, firstMismatch);
+        return 2;
+    }
+    printf("output bit-identical in every block\n");
+    return 0;
+}
+
+// ============================================================================
+// FREQUENCY RESPONSE - SVF cutoff tracking
+// ============================================================================
+
+// |H(f)| of a recorded impulse response (Goertzel)
+static double responseAt(const std::vector<float>& ir, double freq, double sr) {
+    double coef = 2.0 * cos(2.0 * M_PI * freq / sr);
+    double s1 = 0.0, s2 = 0.0;
+    for (size_t n = 0; n < ir.size(); n++) {
+        double s0 = ir[n] + coef * s1 - s2;
+        s2 = s1;
+        s1 = s0;
+    }
+    return sqrt(s1 * s1 + s2 * s2 - coef * s1 * s2);
+}
+
+// Strongest frequency between lo and hi: log grid, then a linear pass
+// around the best grid point
+static double findPeak(const std::vector<float>& ir, double lo, double hi, double sr) {
+    const int kGrid = 240;
+    double ratio = pow(hi / lo, 1.0 / kGrid);
+    double best = lo, bestMag = -1.0;
+    for (int i = 0; i <= kGrid; i++) {
+        double f = lo * pow(ratio, i);
+        double mag = responseAt(ir, f, sr);
+        if (mag > bestMag) { bestMag = mag; best = f; }
+    }
+    double fineLo = best / ratio, fineHi = best * ratio;
+    for (int i = 0; i <= kGrid; i++) {
+        double f = fineLo + (fineHi - fineLo) * i / kGrid;
+        double mag = responseAt(ir, f, sr);
+        if (mag > bestMag) { bestMag = mag; best = f; }
+    }
+    return best;
+}
+
+static int cmdFreqResp(const PatchOptions& opts) {
+    const double sr = (double)opts.sampleRate;
+    
+    // The kernel itself, over the whole range it is specified for
+    double worst = 0.0, worstAt = 0.0;
+    for (int i = 1; i <= 100000; i++) {
+        float x = (float)(0.49 * M_PI * i / 100000.0);
+        double err = fabs((double)fast_tan(x) / tan((double)x) - 1.0);
+        if (err > worst) { worst = err; worstAt = x / M_PI; }
+    }
+    printf("fast_tan: max relative error %.2e (at %.3f*sr), range 0-0.49*sr\n", worst, worstAt);
+    
+    // The filter: hold the gate at the target cutoff, strike it with an
+    // impulse and find the bandpass peak, which the bilinear transform puts
+    // exactly on the prewarped cutoff
+    static const char* const tierNames[] = { "Eco", "Standard", "HQ" };
+    const double maxCutoff = sr * 0.45;
+    const double targets[] = { 100.0, 1000.0, 4000.0, 8000.0, 12000.0, 16000.0, 20000.0, maxCutoff };
+    const float resonance = 0.9f;
+    const int kWarmup = 4096;
+    const int kLength = 32768;
+    
+    printf("resonance %.0f%%, %u Hz\n", resonance * 100.0f, opts.sampleRate);
+    printf("%-9s %10s %10s %8s\n", "tier", "target Hz", "peak Hz", "cents");
+    std::vector<float> ir(kLength);
+    double worstCents = 0.0;
+    for (int tier = QUALITY_ECO; tier <= QUALITY_HQ; tier++) {
+        for (double target : targets) {
+            if (target > maxCutoff) continue;
+            BuchlaLPGFilter filter;
+            filter.setSampleRate((float)sr);
+            filter.setResonance(resonance);
+            // Bright 200% so the gate reaches 0.45*sr at any rate
+            filter.setBrightness(2.0f);
+            filter.setQuality((QualityTier)tier);
+            float gate = (float)((target - 20.0) / (2.0 * (kFullGateCutoff - 20.0)));
+            for (int n = 0; n < kWarmup; n++) filter.process(0.0f, gate, 1.0f);
+            for (int n = 0; n < kLength; n++) {
+                filter.process(n == 0 ? 1.0e-3f : 0.0f, gate, 1.0f);
+                ir[n] = filter.getBandpass();
+            }
+            
+            double peak = findPeak(ir, target * 0.5, fmin(target * 2.0, sr * 0.499), sr);
+            double cents = 1200.0 * log2(peak / target);
+            if (fabs(cents) > fabs(worstCents)) worstCents = cents;
+            printf("%-9s %10.1f %10.1f %8.2f\n", tierNames[tier], target, peak, cents);
+        }
+    }
+    printf("worst cutoff error %.2f cents\n", worstCents);
+    return 0;
+}
+
+// ============================================================================
+// ANALYSIS - Aliasing, THD+N and response per setting, next to their cost
+// ============================================================================
+
+#if defined(__x86_64__) || defined(__i386__)
+// Time-stamp counter: cycles at the nominal clock
+static inline uint64_t analysisCycles() { return __rdtsc(); }
+static const char* const kAnalysisCycleUnit = "cyc";
+#else
+static inline uint64_t analysisCycles() {
+    return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+static const char* const kAnalysisCycleUnit = "ns";
+#endif
+
+// In-place radix-2 FFT, size a power of two
+static void fft(std::vector<std::complex<double> >& x) {
+    const size_t n = x.size();
+    for (size_t i = 1, j = 0; i < n; i++) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) j ^= bit;
+        j ^= bit;
+        if (i < j) std::swap(x[i], x[j]);
+    }
+    for (size_t len = 2; len <= n; len <<= 1) {
+        std::complex<double> step = std::polar(1.0, -2.0 * M_PI / (double)len);
+        for (size_t i = 0; i < n; i += len) {
+            std::complex<double> w(1.0, 0.0);
+            for (size_t k = 0; k < len / 2; k++) {
+                std::complex<double> a = x[i + k];
+                std::complex<double> b = x[i + k + len / 2] * w;
+                x[i + k] = a + b;
+                x[i + k + len / 2] = a - b;
+                w *= step;
+            }
+        }
+    }
+}
+
+// Analysis length and the settle time before it. Tones sit on odd bins:
+// with a power-of-two length every harmonic that folds past Nyquist then
+// lands between the in-band harmonics, so aliasing and THD separate.
+static const int kAnalysisLength = 16384;
+static const int kAnalysisSettle = 16384;
+static const double kSweepHz[] = { 100.0, 440.0, 1000.0, 3000.0, 7000.0 };
+static const int kNumSweepTones = (int)ARRAY_SIZE(kSweepHz);
+static const double kMultiHz[] = { 220.0, 700.0, 1900.0, 4100.0, 9100.0 };
+static const int kNumMultiTones = (int)ARRAY_SIZE(kMultiHz);
+
+static int toneBin(double hz, double sr) {
+    int bin = (int)(hz * kAnalysisLength / sr + 0.5);
+    return bin | 1;
+}
+
+struct ToneResult {
+    double gain;        // Fundamental out / in
+    double thdN;        // Everything but the fundamental, relative to it
+    double alias;       // Non-harmonic bins only, relative to the fundamental
+};
+
+struct VariantResult {
+    double cyclesPerSample = 0.0;
+    ToneResult sweep[kNumSweepTones];
+    double multiNoise = 0.0;    // Energy outside the multitone bins, relative to the tones
+};
+
+// Power spectrum of the last kAnalysisLength samples
+static std::vector<double> powerSpectrum(const std::vector<float>& out) {
+    std::vector<std::complex<double> > x(kAnalysisLength);
+    for (int n = 0; n < kAnalysisLength; n++) x[n] = out[kAnalysisSettle + n];
+    fft(x);
+    std::vector<double> power(kAnalysisLength / 2 + 1);
+    for (size_t b = 0; b < power.size(); b++) power[b] = std::norm(x[b]);
+    return power;
+}
+
+// Runs one channel over the input at a fixed gate; returns cycles spent
+static uint64_t runChannel(const std::vector<float>& in, std::vector<float>& out, double sr,
+                           int material, int fx, float resonance, int tier, const PatchOptions& opts) {
+    std::unique_ptr<LPGChannel> channel(new LPGChannel());
+    channel->setSampleRate((float)sr);
+    channel->setQuality((QualityTier)tier);
+    channel->setParams(resonance, 0.5f, 1.0f, 0.0f, (MaterialMode)material, (FXMode)fx,
+                       opts.analysisFXAmount, 1.0f, false);
+    // CV mode with a steady LED holds the vactrol, and so both gates, still
+    channel->setCVMode(true);
+    channel->setLED(opts.analysisGate);
+    
+    FlushDenormalsScope flushDenormals;
+    uint64_t start = analysisCycles();
+    for (size_t n = 0; n < in.size(); n++) out[n] = channel->process(in[n]);
+    return analysisCycles() - start;
+}
+
+static VariantResult analyseVariant(int material, int fx, float resonance, int tier,
+                                    const PatchOptions& opts) {
+    const double sr = (double)opts.sampleRate;
+    const int total = kAnalysisSettle + kAnalysisLength;
+    std::vector<float> in(total), out(total);
+    VariantResult result;
+    uint64_t cycles = 0;
+    long samples = 0;
+    
+    for (int t = 0; t < kNumSweepTones; t++) {
+        int k = toneBin(kSweepHz[t], sr);
+        for (int n = 0; n < total; n++) {
+            in[n] = opts.analysisLevel * (float)sin(2.0 * M_PI * k * n / kAnalysisLength);
+        }
+        cycles += runChannel(in, out, sr, material, fx, resonance, tier, opts);
+        samples += total;
+        
+        std::vector<double> power = powerSpectrum(out);
+        double fundamental = power[k], harmonics = 0.0, rest = 0.0;
+        for (size_t b = 1; b < power.size(); b++) {
+            if ((int)b == k) continue;
+            if (b % k == 0) harmonics += power[b];
+            else rest += power[b];
+        }
+        // A full-scale bin of an N-point FFT holds (A * N / 2)^2
+        double amplitude = 2.0 * sqrt(fundamental) / kAnalysisLength;
+        result.sweep[t].gain = amplitude / opts.analysisLevel;
+        result.sweep[t].thdN = (harmonics + rest) / fundamental;
+        result.sweep[t].alias = rest / fundamental;
+    }
+    
+    int bins[kNumMultiTones];
+    for (int m = 0; m < kNumMultiTones; m++) bins[m] = toneBin(kMultiHz[m], sr);
+    for (int n = 0; n < total; n++) {
+        double sum = 0.0;
+        for (int m = 0; m < kNumMultiTones; m++) sum += sin(2.0 * M_PI * bins[m] * n / kAnalysisLength + m);
+        in[n] = opts.analysisLevel / kNumMultiTones * (float)sum;
+    }
+    cycles += runChannel(in, out, sr, material, fx, resonance, tier, opts);
+    samples += total;
+    
+    std::vector<double> power = powerSpectrum(out);
+    double tones = 0.0, rest = 0.0;
+    for (size_t b = 1; b < power.size(); b++) {
+        bool isTone = false;
+        for (int m = 0; m < kNumMultiTones; m++) isTone |= ((int)b == bins[m]);
+        (isTone ? tones : rest) += power[b];
+    }
+    result.multiNoise = rest / tones;
+    result.cyclesPerSample = (double)cycles / (double)samples;
+    return result;
+}
+
+static double toDb(double powerRatio) {
+    return 10.0 * log10(fmax(powerRatio, 1.0e-30));
+}
+
+static int cmdAnalyze(const PatchOptions& opts) {
+    static const char* const tierNames[] = { "Eco", "Standard", "HQ" };
+    static const float kResonances[] = { 0.0f, 0.5f, 0.9f };
+    
+    FILE* csv = nullptr;
+    if (!opts.outPath.empty()) {
+        csv = fopen(opts.outPath.c_str(), "w");
+        if (!csv) {
+            fprintf(stderr, "analyze: cannot open %s\n", opts.outPath.c_str());
+            return 1;
+        }
+        fprintf(csv, "material,fx,resonance,tier,%s_per_sample,thdn_db,alias_db,multitone_db,response_error_db\n",
+                kAnalysisCycleUnit);
+    }
+    
+    printf("level %.2fV, gate %.2f, FX amount %.0f%%, %u Hz; sweep", opts.analysisLevel,
+           opts.analysisGate, opts.analysisFXAmount * 100.0f, opts.sampleRate);
+    for (double hz : kSweepHz) printf(" %.0f", hz);
+    printf(" Hz\n");
+    printf("worst over the sweep; response error is against HQ at the same setting\n");
+    printf("%-8s %-9s %4s %-9s %8s %9s %9s %9s %9s\n", "material", "fx", "res", "tier",
+           (std::string(kAnalysisCycleUnit) + "/smp").c_str(), "THD+N dB", "alias dB", "multi dB", "resp dB");
+    
+    for (int material = MATERIAL_NATURAL; material <= MATERIAL_SOFT; material++) {
+        for (int fx = FX_CLEAN; fx <= FX_GRIT; fx++) {
+            for (float res : kResonances) {
+                VariantResult results[3];
+                for (int tier = QUALITY_ECO; tier <= QUALITY_HQ; tier++) {
+                    results[tier] = analyseVariant(material, fx, res, tier, opts);
+                }
+                for (int tier = QUALITY_ECO; tier <= QUALITY_HQ; tier++) {
+                    const VariantResult& r = results[tier];
+                    double thdN = 0.0, alias = 0.0, responseError = 0.0;
+                    for (int t = 0; t < kNumSweepTones; t++) {
+                        thdN = fmax(thdN, r.sweep[t].thdN);
+                        alias = fmax(alias, r.sweep[t].alias);
+                        double err = 20.0 * log10(r.sweep[t].gain / results[QUALITY_HQ].sweep[t].gain);
+                        if (fabs(err) > fabs(responseError)) responseError = err;
+                    }
+                    printf("%-8s %-9s %3.0f%% %-9s %8.1f %9.1f %9.1f %9.1f %9.2f\n",
+                           materialStrings[material], fxStrings[fx], res * 100.0f, tierNames[tier],
+                           r.cyclesPerSample, toDb(thdN), toDb(alias), toDb(r.multiNoise), responseError);
+                    if (csv) {
+                        fprintf(csv, "%s,%s,%.0f,%s,%.2f,%.2f,%.2f,%.2f,%.3f\n",
+                                materialStrings[material], fxStrings[fx], res * 100.0f, tierNames[tier],
+                                r.cyclesPerSample, toDb(thdN), toDb(alias), toDb(r.multiNoise), responseError);
+                    }
+                }
+            }
+        }
+    }
+    if (csv) fclose(csv);
+    return 0;
+}
+
+// ============================================================================
+// SAMPLE RATE CHECK - One strike at 44.1 to 192kHz, compared in time
+//
+// Every time constant is derived from the running rate, so the same patch
+// should decay, sit and sound the same at every rate. Each scenario is one
+// trigger at t=0 into the test patch; the envelope output gives decay
+// times, the left output its level over three windows and its brightness.
+// Every other rate must land within tolerance of 48k. The cost column is
+// step() time per second of audio: only the per-sample stages should
+// scale with the rate (in Standard and HQ, the envelope is one of them).
+// ============================================================================
+
+struct SrScenario {
+    const char* name;
+    const char* params[3];      // "Name=value", nullptr-terminated
+    float gateMs;
+};
+
+static const SrScenario kSrScenarios[] = {
+    { "natural",  { nullptr },                                   5.0f },
+    { "hard",     { "Material=1", "Resonance=70", nullptr },     5.0f },
+    { "soft",     { "Material=2", nullptr },                     5.0f },
+    { "eco",      { "Quality=0", "Resonance=50", nullptr },      5.0f },
+    { "hq-tube",  { "Quality=2", "FX=1", "FX Amount=70" },       5.0f },
+    { "grit",     { "FX=3", "FX Amount=90", nullptr },           5.0f },
+    { "body",     { "Body=1", nullptr },                         5.0f },
+    { "cv-gate",  { "Trig Source=2", nullptr },                  150.0f },
+    { "decay-cv", { "Decay CV=4", "Open CV=5", nullptr },        5.0f },
+};
+
+static const uint32_t kSrRates[] = { 44100, 48000, 96000, 192000 };
+static const int kNumSrRates = (int)ARRAY_SIZE(kSrRates);
+static const float kSrFallDb[3] = { 6.0f, 20.0f, 40.0f };
+static const float kSrWindowMs[4] = { 0.0f, 20.0f, 100.0f, 400.0f };
+static const float kSrSeconds = 2.0f;
+static const int kSrEnvBus = 15;
+
+struct SrMeasure {
+    float peak = 0.0f;          // Env output, V
+    float fallMs[3];            // Env output kSrFallDb below its peak; -1 if it never got there
+    float levelDb[3];           // Left output RMS over the kSrWindowMs windows
+    float brightness = 0.0f;    // Share of the first 50ms output energy above 1kHz
+    double usPerSecond = 0.0;   // step() time per second of audio
+};
+
+static bool measureRate(const PatchOptions& base, const SrScenario& scenario, uint32_t rate, SrMeasure& m) {
+    PatchOptions opts = base;
+    opts.sampleRate = rate;
+    opts.seconds = kSrSeconds;
+    opts.trigIntervalMs = kSrSeconds * 1000.0f;     // One pulse, at t=0
+    opts.gateMs = scenario.gateMs;
+    opts.audioHits = false;
+    opts.midiIntervalMs = 0.0f;
+    for (int i = 0; i < 3 && scenario.params[i]; i++) {
+        std::string kv = scenario.params[i];
+        size_t eq = kv.find('=');
+        opts.params.push_back(std::make_pair(kv.substr(0, eq), atoi(kv.c_str() + eq + 1)));
+    }
+    opts.params.push_back(std::make_pair(std::string("Env Follower"), 1));
+    opts.params.push_back(std::make_pair(std::string("Env Output"), kSrEnvBus));
+    
+    NtHostInstance inst;
+    if (!createInstance(inst, opts)) return false;
+    
+    const int block = opts.blockFrames;
+    const long numFrames = (long)(kSrSeconds * rate) / block * block;
+    std::vector<float> bus(kNtHostNumBusses * block);
+    std::vector<float> env(numFrames), out(numFrames);
+    TestPatch patch(opts);
+    std::chrono::steady_clock::duration busy(0);
+    for (long start = 0; start < numFrames; start += block) {
+        patch.fill(bus.data(), block);
+        auto t0 = std::chrono::steady_clock::now();
+        ntHostStep(inst, bus.data(), block);
+        busy += std::chrono::steady_clock::now() - t0;
+        memcpy(&out[start], &bus[12 * block], block * sizeof(float));
+        memcpy(&env[start], &bus[(kSrEnvBus - 1) * block], block * sizeof(float));
+    }
+    m.usPerSecond = std::chrono::duration<double, std::micro>(busy).count() / kSrSeconds;
+    
+    long peakAt = 0;
+    for (long n = 0; n < numFrames; n++) {
+        if (env[n] > m.peak) { m.peak = env[n]; peakAt = n; }
+    }
+    for (int f = 0; f < 3; f++) {
+        float threshold = m.peak * powf(10.0f, -kSrFallDb[f] / 20.0f);
+        m.fallMs[f] = -1.0f;
+        for (long n = peakAt; n < numFrames; n++) {
+            if (env[n] < threshold) { m.fallMs[f] = 1000.0f * n / rate; break; }
+        }
+    }
+    for (int w = 0; w < 3; w++) {
+        long from = (long)(kSrWindowMs[w] * 0.001f * rate), to = (long)(kSrWindowMs[w + 1] * 0.001f * rate);
+        double sum = 0.0;
+        for (long n = from; n < to; n++) sum += (double)out[n] * out[n];
+        m.levelDb[w] = (float)(10.0 * log10(sum / (double)(to - from) + 1e-20));
+    }
+    
+    // One-pole split at 1kHz, coefficient from the rate like everything else
+    float a = 1.0f - expf(-TWO_PI * 1000.0f / (float)rate);
+    float lp = 0.0f;
+    double high = 0.0, all = 0.0;
+    for (long n = 0; n < (long)(0.05f * rate); n++) {
+        lp += a * (out[n] - lp);
+        high += (double)(out[n] - lp) * (out[n] - lp);
+        all += (double)out[n] * out[n];
+    }
+    m.brightness = all > 0.0 ? (float)(high / all) : 0.0f;
+    return true;
+}
+
+// Tolerances against 48k: a few samples or percent on the times (triggers
+// and control updates land on whole samples), half a dB on the levels
+static bool srCompare(const SrMeasure& m, const SrMeasure& ref, std::string& what) {
+    char buf[64];
+    bool ok = true;
+    if (fabsf(m.peak - ref.peak) > 0.02f * ref.peak + 0.01f) {
+        snprintf(buf, sizeof(buf), " peak %+.3fV", m.peak - ref.peak);
+        what += buf, ok = false;
+    }
+    for (int f = 0; f < 3; f++) {
+        if ((m.fallMs[f] < 0.0f) != (ref.fallMs[f] < 0.0f)) {
+            snprintf(buf, sizeof(buf), " -%.0fdB reached at one rate only", kSrFallDb[f]);
+            what += buf, ok = false;
+        } else if (ref.fallMs[f] >= 0.0f && fabsf(m.fallMs[f] - ref.fallMs[f]) > 0.03f * ref.fallMs[f] + 0.5f) {
+            snprintf(buf, sizeof(buf), " -%.0fdB %+.2fms", kSrFallDb[f], m.fallMs[f] - ref.fallMs[f]);
+            what += buf, ok = false;
+        }
+    }
+    for (int w = 0; w < 3; w++) {
+        if (ref.levelDb[w] > -120.0f && fabsf(m.levelDb[w] - ref.levelDb[w]) > 0.5f) {
+            snprintf(buf, sizeof(buf), " %.0f-%.0fms %+.2fdB", kSrWindowMs[w], kSrWindowMs[w + 1],
+                     m.levelDb[w] - ref.levelDb[w]);
+            what += buf, ok = false;
+        }
+    }
+    if (fabsf(m.brightness - ref.brightness) > 0.03f) {
+        snprintf(buf, sizeof(buf), " >1kHz %+.3f", m.brightness - ref.brightness);
+        what += buf, ok = false;
+    }
+    return ok;
+}
+
+static int cmdSrCheck(const PatchOptions& opts) {
+    printf("one strike per render, %.1fs, block %d; -p settings apply to every scenario\n", kSrSeconds, opts.blockFrames);
+    printf("%-9s %6s %6s %7s %7s %7s %7s %7s %7s %6s %8s %6s\n", "scenario", "rate", "peakV",
+           "-6dB", "-20dB", "-40dB", "0-20", "20-100", "100-400", ">1kHz", "us/s", "x48k");
+    int failures = 0;
+    for (const SrScenario& scenario : kSrScenarios) {
+        SrMeasure m[kNumSrRates];
+        int refIndex = 0;
+        for (int r = 0; r < kNumSrRates; r++) {
+            if (!measureRate(opts, scenario, kSrRates[r], m[r])) return 1;
+            if (kSrRates[r] == 48000) refIndex = r;
+        }
+        for (int r = 0; r < kNumSrRates; r++) {
+            printf("%-9s %6u %6.3f", r == 0 ? scenario.name : "", kSrRates[r], m[r].peak);
+            for (int f = 0; f < 3; f++) {
+                if (m[r].fallMs[f] < 0.0f) printf(" %7s", "-");
+                else printf(" %7.2f", m[r].fallMs[f]);
+            }
+            for (int w = 0; w < 3; w++) printf(" %7.2f", m[r].levelDb[w]);
+            printf(" %6.3f %8.0f %6.2f\n", m[r].brightness, m[r].usPerSecond,
+                   m[r].usPerSecond / m[refIndex].usPerSecond);
+        }
+        for (int r = 0; r < kNumSrRates; r++) {
+            std::string what;
+            if (r == refIndex || srCompare(m[r], m[refIndex], what)) continue;
+            printf("  %u Hz differs from 48000 Hz:%s\n", kSrRates[r], what.c_str());
+            failures++;
+        }
+    }
+    printf(failures ? "%d rate(s) out of tolerance\n" : "every rate within tolerance of 48kHz\n", failures);
+    return failures ? 1 : 0;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static void usage() {
+    fprintf(stderr,
+        "usage: hmhost <command> [options]\n"
+        "commands: profile health trace capture replay <file> freqresp analyze srcheck\n"
+        "options: --sr <hz> --block <frames> --seconds <s> --trig-ms <ms> --gate-ms <ms> --hits --midi-ms <ms>\n"
+        "         -p <Name=value> -a <Name=value@s> --screen\n"
+        "         --out <file> --binary --trace-at <s> --trace-decim <n>\n"
+        "         --level <V> --gate <0-1> --fx-amount <pct>\n");
+}
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        usage();
+        return 1;
+    }
+    std::string command = argv[1];
+    PatchOptions opts;
+    int firstOption = 2;
+    if (command == "replay") {
+        if (argc < 3) {
+            usage();
+            return 1;
+        }
+        opts.inPath = argv[2];
+        firstOption = 3;
+    }
+    
+    for (int a = firstOption; a < argc; a++) {
+        std::string arg = argv[a];
+        bool hasValue = (a + 1 < argc);
+        if (arg == "--sr" && hasValue) {
+            opts.sampleRate = (uint32_t)atoi(argv[++a]);
+        } else if (arg == "--block" && hasValue) {
+            opts.blockFrames = atoi(argv[++a]);
+        } else if (arg == "--seconds" && hasValue) {
+            opts.seconds = (float)atof(argv[++a]);
+        } else if (arg == "--trig-ms" && hasValue) {
+            opts.trigIntervalMs = (float)atof(argv[++a]);
+        } else if (arg == "--gate-ms" && hasValue) {
+            opts.gateMs = (float)atof(argv[++a]);
+        } else if (arg == "--hits") {
+            opts.audioHits = true;
+        } else if (arg == "--midi-ms" && hasValue) {
+            opts.midiIntervalMs = (float)atof(argv[++a]);
+        } else if (arg == "-p" && hasValue) {
+            std::string kv = argv[++a];
+            size_t eq = kv.find('=');
+            if (eq == std::string::npos) {
+                usage();
+                return 1;
+            }
+            opts.params.push_back(std::make_pair(kv.substr(0, eq), atoi(kv.c_str() + eq + 1)));
+        } else if (arg == "-a" && hasValue) {
+            std::string kv = argv[++a];
+            size_t eq = kv.find('=');
+            size_t at = kv.find('@');
+            if (eq == std::string::npos || at == std::string::npos || at < eq) {
+                usage();
+                return 1;
+            }
+            Automation automation;
+            automation.name = kv.substr(0, eq);
+            automation.value = atoi(kv.c_str() + eq + 1);
+            automation.atSeconds = (float)atof(kv.c_str() + at + 1);
+            opts.automation.push_back(automation);
+        } else if (arg == "--screen") {
+            opts.screen = true;
+        } else if (arg == "--out" && hasValue) {
+            opts.outPath = argv[++a];
+        } else if (arg == "--binary") {
+            opts.binary = true;
+        } else if (arg == "--trace-at" && hasValue) {
+            opts.traceAtSeconds = (float)atof(argv[++a]);
+        } else if (arg == "--trace-decim" && hasValue) {
+            opts.traceDecimation = atoi(argv[++a]);
+        } else if (arg == "--level" && hasValue) {
+            opts.analysisLevel = (float)atof(argv[++a]);
+        } else if (arg == "--gate" && hasValue) {
+            opts.analysisGate = (float)atof(argv[++a]);
+        } else if (arg == "--fx-amount" && hasValue) {
+            opts.analysisFXAmount = (float)atof(argv[++a]) / 100.0f;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (opts.blockFrames <= 0 || (opts.blockFrames & 3) != 0) {
+        fprintf(stderr, "--block must be a positive multiple of 4\n");
+        return 1;
+    }
+    
+    if (command == "profile") return cmdProfile(opts);
+    if (command == "health") return cmdHealth(opts);
+    if (command == "trace") return cmdTrace(opts);
+    if (command == "capture") return cmdCapture(opts);
+    if (command == "replay") return cmdReplay(opts);
+    if (command == "freqresp") return cmdFreqResp(opts);
+    if (command == "analyze") return cmdAnalyze(opts);
+    if (command == "srcheck") return cmdSrCheck(opts);
+    
+    usage();
+    return 1;
+}
@@ -0,0 +1,370 @@
+/*
+ * hmload - multi-instance real-time load simulator
+ *
+ * Builds the plugin exactly as for the module (no profiler, trace or
+ * capture) and runs N instances on one audio thread that wakes on a
+ * wall-clock deadline every block, as the NT's audio interrupt does, and
+ * steps every instance in turn over one shared bus frame. Each instance
+ * count runs for --seconds and reports its load against the block
+ * deadline, the misses and the thread's wake-up jitter; the last line is
+ * the largest count that stayed within the headroom target.
+ *
+ * Usage: hmload [options]
+ *
+ * Options:
+ *   --instances <a[:b]>  instance counts to test, a to b (default 1:16)
+ *   --mixed              rotate configurations across instances: stereo/mono,
+ *                        FX mode, CV patched or not, trigger density, material,
+ *                        resonance, body
+ *   -p <Name=value>      parameter for every instance, applied after --mixed
+ *                        (the preset under test)
+ *   --cpu-scale <x>      the module is x times slower than this host; each
+ *                        block's measured work is multiplied by x before it is
+ *                        held against the deadline (default 1). Calibrate by
+ *                        comparing hmhost profile with the module's CPU page.
+ *   --headroom <pct>     share of the deadline that must stay free for a count
+ *                        to be called safe (default 30)
+ *   --sr <hz>            sample rate (default 48000)
+ *   --block <frames>     frames per step(), multiple of 4 (default 32)
+ *   --seconds <s>        run length per instance count (default 3)
+ *   --no-rt              stay at normal priority instead of SCHED_FIFO
+ *
+ * Shared patch (the NT's bus frame, every instance reads the same buses):
+ *   bus 1/2    saws 110/165Hz + noise      bus 4-8  slow LFOs, ±2.5V
+ *   bus 3      triggers every 250ms        bus 9    triggers every 60ms
+ *   bus 10     triggers every 1s           bus 11   triggers every 125ms
+ *   bus 13/14  outputs (instances add into them)
+ *
+ * Load is scaled work / period. A block overruns when its scaled work alone
+ * exceeds the period, and misses when wake-up latency plus scaled work does;
+ * jitter is how late the thread woke. The module's audio interrupt barely
+ * jitters, so the safe count goes by overruns and p99 headroom, while
+ * misses and jitter show how much a desktop scheduler adds on top.
+ */
+
+#include "../holyMackerel.cpp"
+#include "ntHost.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdlib.h>
+#include <sys/mman.h>
+#include <time.h>
+
+#include <algorithm>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// ============================================================================
+// OPTIONS
+// ============================================================================
+
+struct LoadOptions {
+    uint32_t sampleRate = 48000;
+    int blockFrames = 32;
+    float seconds = 3.0f;
+    int minInstances = 1;
+    int maxInstances = 16;
+    bool mixed = false;
+    float cpuScale = 1.0f;
+    float headroom = 0.30f;
+    bool realtime = true;
+    std::vector<std::pair<std::string, int> > params;
+};
+
+// ============================================================================
+// SHARED PATCH
+// ============================================================================
+
+static const int kNumTriggerBuses = 4;
+static const int kTriggerBuses[kNumTriggerBuses] = { 3, 9, 10, 11 };       // 1-based
+static const float kTriggerMs[kNumTriggerBuses] = { 250.0f, 60.0f, 1000.0f, 125.0f };
+
+class SharedPatch {
+public:
+    explicit SharedPatch(uint32_t sampleRate) : sr((float)sampleRate) {
+        for (int t = 0; t < kNumTriggerBuses; t++) {
+            trigPeriod[t] = (long)(kTriggerMs[t] * 0.001f * sr);
+        }
+        pulseLength = (long)(0.005f * sr);
+    }
+    
+    // Inputs for the next block; outputs cleared
+    void fill(float* bus, int numFrames) {
+        for (int i = 0; i < numFrames; i++) {
+            long n = frame + i;
+            seed = seed * 1664525u + 1013904223u;
+            float noise = (float)(seed >> 8) / 16777216.0f * 2.0f - 1.0f;
+            
+            phaseL += 110.0f / sr;
+            if (phaseL >= 1.0f) phaseL -= 1.0f;
+            phaseR += 164.8f / sr;
+            if (phaseR >= 1.0f) phaseR -= 1.0f;
+            bus[0 * numFrames + i] = (2.0f * phaseL - 1.0f) * 4.0f + noise * 0.2f;
+            bus[1 * numFrames + i] = (2.0f * phaseR - 1.0f) * 4.0f;
+            
+            for (int t = 0; t < kNumTriggerBuses; t++) {
+                bool high = (n % trigPeriod[t]) < pulseLength;
+                bus[(kTriggerBuses[t] - 1) * numFrames + i] = high ? 5.0f : noise * 0.01f;
+            }
+            for (int c = 0; c < 5; c++) {
+                float rate = 0.13f + 0.11f * c;
+                bus[(3 + c) * numFrames + i] = 2.5f * sinf(TWO_PI * rate * (float)n / sr);
+            }
+        }
+        for (int b = 11; b < kNtHostNumBusses; b++) {
+            memset(bus + b * numFrames, 0, numFrames * sizeof(float));
+        }
+        frame += numFrames;
+    }
+    
+private:
+    float sr;
+    long frame = 0;
+    uint32_t seed = 12345;
+    float phaseL = 0.0f, phaseR = 0.0f;
+    long trigPeriod[kNumTriggerBuses] = {};
+    long pulseLength = 0;
+};
+
+// ============================================================================
+// INSTANCES
+// ============================================================================
+
+static bool setParam(NtHostInstance& inst, const std::string& name, int value) {
+    int index = ntHostFindParameter(inst, name.c_str());
+    if (index < 0) {
+        fprintf(stderr, "unknown parameter '%s'\n", name.c_str());
+        return false;
+    }
+    ntHostSetParameter(inst, index, (int16_t)value);
+    return true;
+}
+
+// The i-th configuration of the --mixed rotation. The strides differ so
+// neighbouring instances differ in several ways at once.
+static bool applyMixedConfig(NtHostInstance& inst, int i) {
+    static const int kCVBuses[4] = { 4, 5, 6, 7 };
+    bool ok = setParam(inst, "Stereo", (i % 2 == 0) ? 1 : 0);
+    ok = ok && setParam(inst, "FX", i % 4);
+    ok = ok && setParam(inst, "FX Amount", 60);
+    ok = ok && setParam(inst, "Material", i % 3);
+    ok = ok && setParam(inst, "Resonance", 20 + 15 * (i % 5));
+    ok = ok && setParam(inst, "Body", (i % 3 == 2) ? 1 : 0);
+    ok = ok && setParam(inst, "Trigger Input", kTriggerBuses[(i / 4) % kNumTriggerBuses]);
+    
+    bool cvPatched = ((i / 2) % 2) == 1;
+    ok = ok && setParam(inst, "Decay CV", cvPatched ? kCVBuses[0] : 0);
+    ok = ok && setParam(inst, "Open CV", cvPatched ? kCVBuses[1] : 0);
+    ok = ok && setParam(inst, "FX Amt CV", cvPatched ? kCVBuses[2] : 0);
+    ok = ok && setParam(inst, "Resonance CV", cvPatched ? kCVBuses[3] : 0);
+    return ok;
+}
+
+static bool createInstances(std::vector<NtHostInstance>& instances, int count, const LoadOptions& opts) {
+    const _NT_factory* factory = (const _NT_factory*)pluginEntry(kNT_selector_factoryInfo, 0);
+    instances.clear();
+    instances.resize(count);
+    for (int i = 0; i < count; i++) {
+        if (!ntHostCreate(instances[i], factory)) {
+            fprintf(stderr, "construct failed\n");
+            return false;
+        }
+        if (opts.mixed && !applyMixedConfig(instances[i], i)) return false;
+        for (const auto& p : opts.params) {
+            if (!setParam(instances[i], p.first, p.second)) return false;
+        }
+    }
+    return true;
+}
+
+// ============================================================================
+// DEADLINE-DRIVEN AUDIO THREAD
+// ============================================================================
+
+struct LoadResult {
+    long blocks = 0;
+    long overruns = 0;
+    long misses = 0;
+    float loadAvg = 0.0f;
+    float loadP99 = 0.0f;
+    float loadMax = 0.0f;
+    float jitterAvgUs = 0.0f;
+    float jitterMaxUs = 0.0f;
+};
+
+static inline int64_t monotonicNs() {
+    timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static inline timespec toTimespec(int64_t ns) {
+    timespec ts;
+    ts.tv_sec = (time_t)(ns / 1000000000);
+    ts.tv_nsec = (long)(ns % 1000000000);
+    return ts;
+}
+
+// Sleeps until each block's start time, fills the inputs, then times the
+// step() calls alone - input generation stands in for the codec and is
+// not plugin load
+static void audioThread(std::vector<NtHostInstance>& instances, const LoadOptions& opts,
+                        LoadResult& result) {
+    const int64_t periodNs = (int64_t)opts.blockFrames * 1000000000 / opts.sampleRate;
+    const long numBlocks = (long)(opts.seconds * opts.sampleRate) / opts.blockFrames;
+    std::vector<float> bus(kNtHostNumBusses * opts.blockFrames);
+    std::vector<float> loads(numBlocks);
+    SharedPatch patch(opts.sampleRate);
+    
+    double jitterSum = 0.0;
+    int64_t jitterMax = 0;
+    int64_t next = monotonicNs() + periodNs;
+    for (long b = 0; b < numBlocks; b++, next += periodNs) {
+        timespec wakeAt = toTimespec(next);
+        clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &wakeAt, nullptr);
+        int64_t woke = monotonicNs();
+        int64_t late = std::max<int64_t>(woke - next, 0);
+        
+        patch.fill(bus.data(), opts.blockFrames);
+        int64_t workStart = monotonicNs();
+        for (NtHostInstance& inst : instances) {
+            ntHostStep(inst, bus.data(), opts.blockFrames);
+        }
+        double work = (double)(monotonicNs() - workStart) * opts.cpuScale;
+        
+        loads[b] = (float)(work / (double)periodNs);
+        if (work > (double)periodNs) result.overruns++;
+        if ((double)late + work > (double)periodNs) result.misses++;
+        jitterSum += (double)late;
+        jitterMax = std::max(jitterMax, late);
+        
+        // A block that ran past its successor's start time is not retried:
+        // the module would have dropped it too
+        int64_t now = monotonicNs();
+        if (now > next + periodNs) next = now - periodNs;
+    }
+    
+    result.blocks = numBlocks;
+    double loadSum = 0.0;
+    for (float l : loads) loadSum += l;
+    result.loadAvg = (float)(loadSum / (double)numBlocks);
+    std::sort(loads.begin(), loads.end());
+    result.loadP99 = loads[(size_t)((numBlocks - 1) * 0.99)];
+    result.loadMax = loads.back();
+    result.jitterAvgUs = (float)(jitterSum / (double)numBlocks * 0.001);
+    result.jitterMaxUs = (float)jitterMax * 0.001f;
+}
+
+static bool raisePriority(std::thread& t) {
+    sched_param sp;
+    sp.sched_priority = sched_get_priority_max(SCHED_FIFO) - 1;
+    return pthread_setschedparam(t.native_handle(), SCHED_FIFO, &sp) == 0;
+}
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static void usage() {
+    fprintf(stderr,
+        "usage: hmload [--instances <a[:b]>] [--mixed] [-p <Name=value>]... [--cpu-scale <x>]\n"
+        "              [--headroom <pct>] [--sr <hz>] [--block <frames>] [--seconds <s>] [--no-rt]\n");
+}
+
+int main(int argc, char** argv) {
+    LoadOptions opts;
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        bool hasValue = (a + 1 < argc);
+        if (arg == "--instances" && hasValue) {
+            std::string range = argv[++a];
+            size_t colon = range.find(':');
+            opts.minInstances = atoi(range.c_str());
+            opts.maxInstances = (colon == std::string::npos) ? opts.minInstances
+                                                             : atoi(range.c_str() + colon + 1);
+        } else if (arg == "--mixed") {
+            opts.mixed = true;
+        } else if (arg == "-p" && hasValue) {
+            std::string kv = argv[++a];
+            size_t eq = kv.find('=');
+            if (eq == std::string::npos) {
+                usage();
+                return 1;
+            }
+            opts.params.push_back(std::make_pair(kv.substr(0, eq), atoi(kv.c_str() + eq + 1)));
+        } else if (arg == "--cpu-scale" && hasValue) {
+            opts.cpuScale = (float)atof(argv[++a]);
+        } else if (arg == "--headroom" && hasValue) {
+            opts.headroom = (float)atof(argv[++a]) / 100.0f;
+        } else if (arg == "--sr" && hasValue) {
+            opts.sampleRate = (uint32_t)atoi(argv[++a]);
+        } else if (arg == "--block" && hasValue) {
+            opts.blockFrames = atoi(argv[++a]);
+        } else if (arg == "--seconds" && hasValue) {
+            opts.seconds = (float)atof(argv[++a]);
+        } else if (arg == "--no-rt") {
+            opts.realtime = false;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+    if (opts.blockFrames <= 0 || (opts.blockFrames & 3) != 0) {
+        fprintf(stderr, "--block must be a positive multiple of 4\n");
+        return 1;
+    }
+    if (opts.minInstances < 1 || opts.maxInstances < opts.minInstances || opts.cpuScale <= 0.0f) {
+        usage();
+        return 1;
+    }
+    
+    ntHostSetSampleRate(opts.sampleRate);
+    ntHostSetMaxFramesPerStep(opts.blockFrames);
+    if (opts.realtime) mlockall(MCL_CURRENT | MCL_FUTURE);     // Best effort, like the priority
+    
+    float periodUs = 1.0e6f * opts.blockFrames / opts.sampleRate;
+    printf("%d-frame blocks at %u Hz: %.1f us deadline, cpu scale %.2f, %s\n",
+           opts.blockFrames, opts.sampleRate, periodUs, opts.cpuScale,
+           opts.mixed ? "mixed configurations" : "identical instances");
+    printf("%9s %8s %8s %8s %9s %9s %8s %10s %10s\n",
+           "instances", "load", "p99", "max", "headroom", "overruns", "misses", "jitter us", "max us");
+    
+    int safeCount = opts.minInstances - 1;     // Highest count safe so far, with every count below it
+    bool warnedPriority = false;
+    for (int count = opts.minInstances; count <= opts.maxInstances; count++) {
+        std::vector<NtHostInstance> instances;
+        if (!createInstances(instances, count, opts)) return 1;
+        
+        LoadResult result;
+        std::thread thread(audioThread, std::ref(instances), std::cref(opts), std::ref(result));
+        if (opts.realtime && !raisePriority(thread) && !warnedPriority) {
+            fprintf(stderr, "note: SCHED_FIFO refused, running at normal priority (jitter will show it)\n");
+            warnedPriority = true;
+        }
+        thread.join();
+        
+        float headroom = 1.0f - result.loadP99;
+        printf("%9d %7.1f%% %7.1f%% %7.1f%% %8.1f%% %9ld %8ld %10.1f %10.1f\n", count,
+               100.0f * result.loadAvg, 100.0f * result.loadP99, 100.0f * result.loadMax,
+               100.0f * headroom, result.overruns, result.misses, result.jitterAvgUs, result.jitterMaxUs);
+        fflush(stdout);
+        
+        bool safe = (result.overruns == 0 && headroom >= opts.headroom);
+        if (safe && count == safeCount + 1) safeCount = count;
+        
+        // Well past the cliff - more instances only take longer to say so
+        if (result.overruns * 10 > result.blocks) break;
+    }
+    
+    if (safeCount >= opts.minInstances) {
+        printf("safe: up to %d instance%s (no overruns, at least %.0f%% headroom at p99)\n",
+               safeCount, safeCount == 1 ? "" : "s", 100.0f * opts.headroom);
+    } else {
+        printf("safe: none - even %d instance%s overran or ran short of %.0f%% headroom\n",
+               opts.minInstances, opts.minInstances == 1 ? "" : "s", 100.0f * opts.headroom);
+    }
+    return 0;
+}
@@ -0,0 +1,477 @@
+/*
+ * hmrender - offline sweep renderer for building sample libraries
+ *
+ * Runs every source WAV through the LPG engine (engine/hmEngineApi.h) once
+ * per point of a parameter sweep - Material x FX x Decay x Resonance x
+ * velocity - and writes one float32 WAV per render. Jobs are spread over
+ * all cores by a work-stealing pool; each job builds its own voice in its
+ * worker's memory, so output never depends on scheduling.
+ *
+ * Usage: hmrender --out-dir <dir> [options] <source.wav>...
+ *
+ * Sweep axes (comma lists and/or first:last:step ranges):
+ *   --material <list>  0 Natural, 1 Hard, 2 Soft          (default 0,1,2)
+ *   --fx <list>        0 Clean, 1 Tube, 2 Screamer, 3 Grit (default 0)
+ *   --decay <list>     percent                             (default 50)
+ *   --resonance <list> percent                             (default 0)
+ *   --velocity <list>  percent                             (default 100)
+ *
+ * Fixed settings:
+ *   --fx-amount <pct>  (default 50)     --open <pct>    (default 100)
+ *   --body <0|1>       (default 0)      --quality <0-2> (default 2, HQ)
+ *   --in-gain <x>      WAV full scale -> volts at the LPG input (default 1)
+ *   --tail <s>         render this long past the end of the source (default 1)
+ *
+ * Other options:
+ *   --threads <n>      worker threads (default: all cores)
+ *   --dry-run          print the job count and exit
+ *
+ * Sources: PCM 16/24/32-bit or float32, any rate, first channel used. They
+ * are memory-mapped, never copied. Each render strikes the gate at sample 0
+ * and feeds the source in; outputs are named
+ *   <source>_<Material>_<FX>_d<decay>_r<resonance>_v<velocity>.wav
+ */
+
+#include "../engine/hmEngineApi.h"
+
+#include <fcntl.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+static const char* const kMaterialNames[] = { "Natural", "Hard", "Soft" };
+static const char* const kFXNames[] = { "Clean", "Tube", "Screamer", "Grit" };
+
+// Frames per hmProcessVoices() call - input conversion happens this many at a time
+static const int kRenderBlock = 256;
+
+// Canonical 44-byte header, float32 mono
+static const int kWavHeaderBytes = 44;
+
+// ============================================================================
+// WAV SOURCES - Memory-mapped, decoded a block at a time
+// ============================================================================
+
+enum WavSampleFormat {
+    WAV_PCM16 = 0,
+    WAV_PCM24,
+    WAV_PCM32,
+    WAV_FLOAT32
+};
+
+struct WavSource {
+    std::string path;
+    std::string stem;
+    const uint8_t* map = nullptr;
+    size_t mapBytes = 0;
+    const uint8_t* data = nullptr;
+    uint32_t numFrames = 0;
+    uint32_t sampleRate = 0;
+    int frameBytes = 0;
+    WavSampleFormat format = WAV_PCM16;
+};
+
+static uint32_t readU32(const uint8_t* p) { return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24); }
+static uint16_t readU16(const uint8_t* p) { return (uint16_t)(p[0] | (p[1] << 8)); }
+
+static bool wavOpen(WavSource& src, const std::string& path) {
+    src.path = path;
+    size_t slash = path.find_last_of('/');
+    std::string file = (slash == std::string::npos) ? path : path.substr(slash + 1);
+    size_t dot = file.find_last_of('.');
+    src.stem = (dot == std::string::npos) ? file : file.substr(0, dot);
+    
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "%s: cannot open\n", path.c_str());
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < 12) {
+        fprintf(stderr, "%s: not a WAV file\n", path.c_str());
+        close(fd);
+        return false;
+    }
+    void* map = mmap(nullptr, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) {
+        fprintf(stderr, "%s: mmap failed\n", path.c_str());
+        return false;
+    }
+    src.map = (const uint8_t*)map;
+    src.mapBytes = (size_t)st.st_size;
+    
+    const uint8_t* p = src.map;
+    const uint8_t* end = src.map + src.mapBytes;
+    if (memcmp(p, "RIFF", 4) != 0 || memcmp(p + 8, "WAVE", 4) != 0) {
+        fprintf(stderr, "%s: not a WAV file\n", path.c_str());
+        return false;
+    }
+    
+    // Walk the chunks for 'fmt ' and 'data'
+    uint16_t formatTag = 0, channels = 0, bits = 0;
+    const uint8_t* data = nullptr;
+    uint32_t dataBytes = 0;
+    for (p += 12; p + 8 <= end; ) {
+        uint32_t size = readU32(p + 4);
+        const uint8_t* body = p + 8;
+        if (body + size > end) size = (uint32_t)(end - body);   // Truncated file - use what is there
+        if (memcmp(p, "fmt ", 4) == 0 && size >= 16) {
+            formatTag = readU16(body);
+            channels = readU16(body + 2);
+            src.sampleRate = readU32(body + 4);
+            bits = readU16(body + 14);
+            if (formatTag == 0xFFFE && size >= 26) formatTag = readU16(body + 24);   // WAVE_FORMAT_EXTENSIBLE
+        } else if (memcmp(p, "data", 4) == 0) {
+            data = body;
+            dataBytes = size;
+        }
+        p = body + size + (size & 1);
+    }
+    
+    if (formatTag == 1 && bits == 16) src.format = WAV_PCM16;
+    else if (formatTag == 1 && bits == 24) src.format = WAV_PCM24;
+    else if (formatTag == 1 && bits == 32) src.format = WAV_PCM32;
+    else if (formatTag == 3 && bits == 32) src.format = WAV_FLOAT32;
+    else {
+        fprintf(stderr, "%s: unsupported format (tag %u, %u bits)\n", path.c_str(), formatTag, bits);
+        return false;
+    }
+    if (!data || channels == 0 || src.sampleRate == 0) {
+        fprintf(stderr, "%s: missing fmt or data chunk\n", path.c_str());
+        return false;
+    }
+    src.data = data;
+    src.frameBytes = channels * (bits / 8);
+    src.numFrames = dataBytes / src.frameBytes;
+    return true;
+}
+
+static void wavClose(WavSource& src) {
+    if (src.map) munmap((void*)src.map, src.mapBytes);
+    src.map = nullptr;
+}
+
+// First channel of frames [start, start + n) as floats, zeros past the end
+static void wavRead(const WavSource& src, uint32_t start, int n, float gain, float* out) {
+    int avail = (start < src.numFrames) ? (int)std::min<uint32_t>(src.numFrames - start, (uint32_t)n) : 0;
+    const uint8_t* p = src.data + (size_t)start * src.frameBytes;
+    for (int i = 0; i < avail; i++, p += src.frameBytes) {
+        float x;
+        switch (src.format) {
+            case WAV_PCM16: x = (int16_t)readU16(p) * (1.0f / 32768.0f); break;
+            case WAV_PCM24: x = (float)((int32_t)((p[0] << 8) | (p[1] << 16) | ((uint32_t)p[2] << 24)) >> 8) * (1.0f / 8388608.0f); break;
+            case WAV_PCM32: x = (float)(int32_t)readU32(p) * (1.0f / 2147483648.0f); break;
+            default: { uint32_t u = readU32(p); memcpy(&x, &u, 4); } break;
+        }
+        out[i] = x * gain;
+    }
+    for (int i = avail; i < n; i++) out[i] = 0.0f;
+}
+
+static void writeU32(uint8_t* p, uint32_t v) { p[0] = v; p[1] = v >> 8; p[2] = v >> 16; p[3] = v >> 24; }
+static void writeU16(uint8_t* p, uint16_t v) { p[0] = v; p[1] = v >> 8; }
+
+static void wavHeaderFloat(uint8_t* h, uint32_t sampleRate, uint32_t numFrames) {
+    uint32_t dataBytes = numFrames * 4;
+    memcpy(h, "RIFF", 4);
+    writeU32(h + 4, 36 + dataBytes);
+    memcpy(h + 8, "WAVEfmt ", 8);
+    writeU32(h + 16, 16);
+    writeU16(h + 20, 3);                // IEEE float
+    writeU16(h + 22, 1);
+    writeU32(h + 24, sampleRate);
+    writeU32(h + 28, sampleRate * 4);
+    writeU16(h + 32, 4);
+    writeU16(h + 34, 32);
+    memcpy(h + 36, "data", 4);
+    writeU32(h + 40, dataBytes);
+}
+
+// ============================================================================
+// SWEEP - Every source x every axis combination
+// ============================================================================
+
+struct SweepOptions {
+    std::vector<int> material = { 0, 1, 2 };
+    std::vector<int> fx = { 0 };
+    std::vector<int> decay = { 50 };
+    std::vector<int> resonance = { 0 };
+    std::vector<int> velocity = { 100 };
+    int fxAmount = 50;
+    int open = 100;
+    int body = 0;
+    int quality = HM_QUALITY_HQ;
+    float inGain = 1.0f;
+    float tailSeconds = 1.0f;
+    int threads = 0;
+    bool dryRun = false;
+    std::string outDir;
+};
+
+struct RenderJob {
+    int source;
+    uint8_t material, fx, decay, resonance, velocity;
+};
+
+static std::vector<RenderJob> expandSweep(const SweepOptions& o, int numSources) {
+    std::vector<RenderJob> jobs;
+    jobs.reserve((size_t)numSources * o.material.size() * o.fx.size() * o.decay.size() *
+                 o.resonance.size() * o.velocity.size());
+    for (int s = 0; s < numSources; s++)
+        for (int m : o.material)
+            for (int f : o.fx)
+                for (int d : o.decay)
+                    for (int r : o.resonance)
+                        for (int v : o.velocity)
+                            jobs.push_back({ s, (uint8_t)m, (uint8_t)f, (uint8_t)d, (uint8_t)r, (uint8_t)v });
+    return jobs;
+}
+
+// "0,2,5" and "0:100:25" (inclusive), mixed freely; values clamped to lo..hi
+static bool parseList(const char* text, int lo, int hi, std::vector<int>& out) {
+    out.clear();
+    std::string s = text;
+    size_t pos = 0;
+    while (pos <= s.size()) {
+        size_t comma = s.find(',', pos);
+        std::string item = s.substr(pos, comma == std::string::npos ? std::string::npos : comma - pos);
+        int first, last, step = 1;
+        int n = sscanf(item.c_str(), "%d:%d:%d", &first, &last, &step);
+        if (n < 1 || step <= 0) return false;
+        if (n == 1) last = first;
+        for (int v = first; v <= last; v += step) {
+            if (v < lo || v > hi) return false;
+            out.push_back(v);
+        }
+        if (comma == std::string::npos) break;
+        pos = comma + 1;
+    }
+    return !out.empty();
+}
+
+// ============================================================================
+// WORK-STEALING POOL
+//
+// Jobs are dealt round-robin onto one deque per worker up front. A worker
+// takes from the back of its own deque and, when that runs dry, steals
+// from the front of the others, so long renders (big sources, long tails)
+// even out across cores without a shared queue everyone contends on.
+// ============================================================================
+
+class JobDeque {
+public:
+    void push(int job) { jobs.push_back(job); }
+    
+    bool popBack(int& job) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (jobs.empty()) return false;
+        job = jobs.back();
+        jobs.pop_back();
+        return true;
+    }
+    
+    bool stealFront(int& job) {
+        std::lock_guard<std::mutex> guard(lock);
+        if (jobs.empty()) return false;
+        job = jobs.front();
+        jobs.pop_front();
+        return true;
+    }
+
+private:
+    std::mutex lock;
+    std::deque<int> jobs;
+};
+
+struct WorkerStats {
+    long jobs = 0;
+    long steals = 0;
+    long failed = 0;
+    double frames = 0.0;
+};
+
+// Everything a worker needs, sized once for the longest job
+class RenderWorker {
+public:
+    RenderWorker(uint32_t maxFrames)
+        : voiceMemory(hmVoiceSize() + hmVoiceAlignment()),
+          input(kRenderBlock),
+          file(kWavHeaderBytes + (size_t)maxFrames * sizeof(float)) {}
+    
+    bool render(const RenderJob& job, const WavSource& src, const SweepOptions& o, uint32_t numFrames) {
+        uintptr_t raw = (uintptr_t)voiceMemory.data();
+        uintptr_t align = hmVoiceAlignment();
+        HmVoice* voice = hmVoiceInit((void*)((raw + align - 1) & ~(align - 1)), (float)src.sampleRate);
+        
+        HmVoiceParams params;
+        hmVoiceDefaultParams(&params);
+        params.material = job.material;
+        params.fx = job.fx;
+        params.decay = job.decay / 100.0f;
+        params.resonance = job.resonance / 100.0f;
+        params.fxAmount = o.fxAmount / 100.0f;
+        params.open = o.open / 100.0f;
+        params.body = o.body;
+        params.quality = o.quality;
+        hmVoiceSetParams(voice, &params);
+        hmVoiceStrike(voice, job.velocity / 100.0f);
+        
+        // Output renders straight into the file image after its header
+        float* out = (float*)(file.data() + kWavHeaderBytes);
+        for (uint32_t pos = 0; pos < numFrames; pos += kRenderBlock) {
+            int n = (int)std::min<uint32_t>(kRenderBlock, numFrames - pos);
+            wavRead(src, pos, n, o.inGain, input.data());
+            HmVoiceBuffers buffers = { input.data(), nullptr, out + pos, nullptr };
+            hmProcessVoices(&voice, &buffers, 1, n);
+        }
+        wavHeaderFloat(file.data(), src.sampleRate, numFrames);
+        
+        snprintf(path, sizeof(path), "%s/%s_%s_%s_d%d_r%d_v%d.wav", o.outDir.c_str(), src.stem.c_str(),
+                 kMaterialNames[job.material], kFXNames[job.fx], job.decay, job.resonance, job.velocity);
+        int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (fd < 0) return false;
+        size_t bytes = kWavHeaderBytes + (size_t)numFrames * sizeof(float);
+        bool ok = write(fd, file.data(), bytes) == (ssize_t)bytes;
+        close(fd);
+        return ok;
+    }
+    
+    const char* lastPath() const { return path; }
+
+private:
+    std::vector<uint8_t> voiceMemory;
+    std::vector<float> input;
+    std::vector<uint8_t> file;      // Header + float32 samples, reused for every job
+    char path[1024];
+};
+
+// ============================================================================
+// MAIN
+// ============================================================================
+
+static void usage() {
+    fprintf(stderr,
+            "usage: hmrender --out-dir <dir> [options] <source.wav>...\n"
+            "sweep: --material <list> --fx <list> --decay <list> --resonance <list> --velocity <list>\n"
+            "       (lists: 0,1,2 or first:last:step)\n"
+            "fixed: --fx-amount <pct> --open <pct> --body <0|1> --quality <0-2> --in-gain <x> --tail <s>\n"
+            "other: --threads <n> --dry-run\n");
+}
+
+int main(int argc, char** argv) {
+    SweepOptions o;
+    std::vector<std::string> paths;
+    
+    for (int a = 1; a < argc; a++) {
+        std::string arg = argv[a];
+        bool hasValue = (a + 1 < argc);
+        bool ok = true;
+        if (arg == "--material" && hasValue) ok = parseList(argv[++a], 0, 2, o.material);
+        else if (arg == "--fx" && hasValue) ok = parseList(argv[++a], 0, 3, o.fx);
+        else if (arg == "--decay" && hasValue) ok = parseList(argv[++a], 0, 100, o.decay);
+        else if (arg == "--resonance" && hasValue) ok = parseList(argv[++a], 0, 100, o.resonance);
+        else if (arg == "--velocity" && hasValue) ok = parseList(argv[++a], 0, 100, o.velocity);
+        else if (arg == "--fx-amount" && hasValue) o.fxAmount = atoi(argv[++a]);
+        else if (arg == "--open" && hasValue) o.open = atoi(argv[++a]);
+        else if (arg == "--body" && hasValue) o.body = atoi(argv[++a]);
+        else if (arg == "--quality" && hasValue) o.quality = atoi(argv[++a]);
+        else if (arg == "--in-gain" && hasValue) o.inGain = (float)atof(argv[++a]);
+        else if (arg == "--tail" && hasValue) o.tailSeconds = (float)atof(argv[++a]);
+        else if (arg == "--threads" && hasValue) o.threads = atoi(argv[++a]);
+        else if (arg == "--out-dir" && hasValue) o.outDir = argv[++a];
+        else if (arg == "--dry-run") o.dryRun = true;
+        else if (arg.size() > 1 && arg[0] == '-') ok = false;
+        else paths.push_back(arg);
+        if (!ok) {
+            usage();
+            return 1;
+        }
+    }
+    if (paths.empty() || (o.outDir.empty() && !o.dryRun)) {
+        usage();
+        return 1;
+    }
+    
+    std::vector<WavSource> sources(paths.size());
+    uint32_t maxFrames = 0;
+    std::vector<uint32_t> renderFrames(paths.size());
+    for (size_t s = 0; s < paths.size(); s++) {
+        if (!wavOpen(sources[s], paths[s])) return 1;
+        renderFrames[s] = sources[s].numFrames + (uint32_t)(o.tailSeconds * sources[s].sampleRate);
+        maxFrames = std::max(maxFrames, renderFrames[s]);
+    }
+    
+    std::vector<RenderJob> jobs = expandSweep(o, (int)sources.size());
+    double totalFrames = 0.0, totalSeconds = 0.0;
+    for (const RenderJob& j : jobs) {
+        totalFrames += renderFrames[j.source];
+        totalSeconds += (double)renderFrames[j.source] / sources[j.source].sampleRate;
+    }
+    printf("%zu sources, %zu renders, %.1f s of audio\n", sources.size(), jobs.size(), totalSeconds);
+    if (o.dryRun) return 0;
+    
+    int numWorkers = o.threads > 0 ? o.threads : (int)std::max(1u, std::thread::hardware_concurrency());
+    numWorkers = std::min<int>(numWorkers, std::max<int>(1, (int)jobs.size()));
+    std::vector<JobDeque> queues(numWorkers);
+    for (size_t j = 0; j < jobs.size(); j++) queues[j % numWorkers].push((int)j);
+    
+    std::vector<WorkerStats> stats(numWorkers);
+    std::atomic<long> done(0);
+    auto t0 = std::chrono::steady_clock::now();
+    
+    std::vector<std::thread> threads;
+    for (int w = 0; w < numWorkers; w++) {
+        threads.emplace_back([&, w]() {
+            RenderWorker worker(maxFrames);
+            WorkerStats& st = stats[w];
+            for (;;) {
+                int j;
+                if (!queues[w].popBack(j)) {
+                    bool stolen = false;
+                    for (int k = 1; k < numWorkers && !stolen; k++) {
+                        stolen = queues[(w + k) % numWorkers].stealFront(j);
+                    }
+                    if (!stolen) break;     // Every deque is empty - jobs never arrive late
+                    st.steals++;
+                }
+                const RenderJob& job = jobs[j];
+                if (!worker.render(job, sources[job.source], o, renderFrames[job.source])) {
+                    fprintf(stderr, "%s: write failed\n", worker.lastPath());
+                    st.failed++;
+                }
+                st.jobs++;
+                st.frames += renderFrames[job.source];
+                done++;
+            }
+        });
+    }
+    for (std::thread& t : threads) t.join();
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    
+    long failed = 0;
+    printf("%-8s %8s %8s %12s\n", "worker", "renders", "steals", "Msamples");
+    for (int w = 0; w < numWorkers; w++) {
+        printf("%-8d %8ld %8ld %12.2f\n", w, stats[w].jobs, stats[w].steals, stats[w].frames * 1e-6);
+        failed += stats[w].failed;
+    }
+    printf("%ld renders in %.2f s on %d threads: %.1f renders/s, %.2f Msamples/s, %.0fx real time\n",
+           done.load(), wall, numWorkers, done.load() / wall, totalFrames * 1e-6 / wall, totalSeconds / wall);
+    printf("%.1f MB written\n", (jobs.size() * (double)kWavHeaderBytes + totalFrames * sizeof(float)) / (1024.0 * 1024.0));
+    
+    for (WavSource& s : sources) wavClose(s);
+    return failed ? 1 : 0;
+}
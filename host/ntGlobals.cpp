@@ -0,0 +1,24 @@
+/*
+ * Storage for NT_globals on the host.
+ *
+ * The API declares NT_globals as `extern const` because plugins must never
+ * write it. The host has to set the sample rate, so the object is defined
+ * here, in a translation unit that does not see that declaration, with the
+ * same layout as _NT_globals.
+ */
+
+#include <stdint.h>
+
+struct NtHostGlobals {
+    uint32_t sampleRate;
+    uint32_t maxFramesPerStep;
+    float* workBuffer;
+    uint32_t workBufferSizeBytes;
+};
+
+static float workBuffer[16384];
+
+NtHostGlobals NT_globals = { 48000, 128, workBuffer, sizeof(workBuffer) };
+
+void ntHostSetSampleRate(uint32_t sampleRate) { NT_globals.sampleRate = sampleRate; }
+void ntHostSetMaxFramesPerStep(uint32_t frames) { NT_globals.maxFramesPerStep = frames; }
@@ -0,0 +1,131 @@
+/*
+ * ntHost - see ntHost.h
+ */
+
+#include "ntHost.h"
+
+#include <string.h>
+#include <string>
+#include <algorithm>
+
+uint8_t NT_screen[128 * 64];
+
+struct ScreenText {
+    int x, y;
+    std::string text;
+};
+static std::vector<ScreenText> screenText;
+
+extern "C" {
+
+int NT_drawText(int x, int y, const char* str, int colour, _NT_textAlignment align, _NT_textSize size) {
+    screenText.push_back({ x, y, str });
+    return 0;
+}
+
+void NT_drawShapeI(_NT_shape shape, int x0, int y0, int x1, int y1, int colour) {}
+
+int32_t NT_algorithmIndex(const _NT_algorithm* algorithm) { return 0; }
+
+uint32_t NT_parameterOffset(void) { return 0; }
+
+void NT_setParameterGrayedOut(uint32_t algorithmIndex, uint32_t parameter, bool gray) {}
+
+void NT_setParameterFromUi(uint32_t algorithmIndex, uint32_t parameter, int16_t value) {}
+
+}
+
+// Static memory, one block per factory for the life of the process - the
+// module sets it up once, when the plugin loads
+struct StaticMemory {
+    const _NT_factory* factory;
+    std::vector<uint8_t> dram;
+};
+static std::vector<StaticMemory*> staticMemory;
+
+static void initialiseFactory(const _NT_factory* factory) {
+    for (const StaticMemory* m : staticMemory) {
+        if (m->factory == factory) return;
+    }
+    StaticMemory* m = new StaticMemory { factory, {} };
+    staticMemory.push_back(m);
+    if (!factory->calculateStaticRequirements) return;
+    _NT_staticRequirements req = {};
+    factory->calculateStaticRequirements(req);
+    m->dram.assign(req.dram, 0);
+    _NT_staticMemoryPtrs ptrs = { m->dram.data() };
+    if (factory->initialise) factory->initialise(ptrs, req);
+}
+
+bool ntHostCreate(NtHostInstance& inst, const _NT_factory* factory, const int32_t* specifications) {
+    initialiseFactory(factory);
+    inst.factory = factory;
+    factory->calculateRequirements(inst.req, specifications);
+    
+    inst.sram.assign(inst.req.sram, 0);
+    inst.dram.assign(inst.req.dram, 0);
+    inst.dtc.assign(inst.req.dtc, 0);
+    inst.itc.assign(inst.req.itc, 0);
+    
+    // The module points v at the parameter values before construct(), which
+    // may read them. The parameter table (and so the defaults) is only known
+    // once construct() has run, so start from zeros and announce every
+    // default through parameterChanged() afterwards.
+    inst.values.assign(inst.req.numParameters, 0);
+    _NT_algorithm* header = (_NT_algorithm*)inst.sram.data();
+    header->v = inst.values.data();
+    
+    _NT_algorithmMemoryPtrs ptrs = { inst.sram.data(), inst.dram.data(), inst.dtc.data(), inst.itc.data() };
+    inst.alg = factory->construct(ptrs, inst.req, specifications);
+    if (!inst.alg) return false;
+    
+    for (uint32_t p = 0; p < inst.req.numParameters; p++) {
+        inst.values[p] = inst.alg->parameters[p].def;
+    }
+    inst.alg->v = inst.values.data();
+    inst.alg->vIncludingCommon = inst.values.data();
+    for (uint32_t p = 0; p < inst.req.numParameters; p++) {
+        factory->parameterChanged(inst.alg, (int)p);
+    }
+    return true;
+}
+
+int ntHostFindParameter(const NtHostInstance& inst, const char* name) {
+    for (uint32_t p = 0; p < inst.req.numParameters; p++) {
+        if (strcmp(inst.alg->parameters[p].name, name) == 0) return (int)p;
+    }
+    return -1;
+}
+
+void ntHostSetParameter(NtHostInstance& inst, int p, int16_t value) {
+    const _NT_parameter& param = inst.alg->parameters[p];
+    if (value < param.min) value = param.min;
+    if (value > param.max) value = param.max;
+    inst.values[p] = value;
+    inst.factory->parameterChanged(inst.alg, p);
+}
+
+void ntHostStep(NtHostInstance& inst, float* busFrames, int numFrames) {
+    inst.factory->step(inst.alg, busFrames, numFrames / 4);
+}
+
+void ntHostClearScreen() {
+    screenText.clear();
+}
+
+void ntHostDumpScreen(FILE* out) {
+    std::vector<ScreenText> rows = screenText;
+    std::stable_sort(rows.begin(), rows.end(), [](const ScreenText& a, const ScreenText& b) {
+        return (a.y != b.y) ? (a.y < b.y) : (a.x < b.x);
+    });
+    int lastY = -1;
+    for (const ScreenText& t : rows) {
+        if (t.y != lastY) {
+            if (lastY >= 0) fputc('\n', out);
+            fprintf(out, "%3d |", t.y);
+            lastY = t.y;
+        }
+        fprintf(out, " %s", t.text.c_str());
+    }
+    if (lastY >= 0) fputc('\n', out);
+}
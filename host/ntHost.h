@@ -0,0 +1,49 @@
+/*
+ * ntHost - minimal host-side runtime for running Holy Mackerel off the module
+ *
+ * Provides the NT API symbols the plugin links against (globals, screen,
+ * drawing, parameter greying) and a small wrapper that drives a factory the
+ * same way the module does: static requirements → initialise (once per
+ * factory) → requirements → construct → parameterChanged → step.
+ *
+ * Drawing calls are recorded as text so diagnostic pages can be read back
+ * on the host.
+ */
+
+#pragma once
+
+#include <stdio.h>
+#include <vector>
+#include <distingnt/api.h>
+
+static const int kNtHostNumBusses = 28;
+
+// NT_globals is read-only for plugins; the host owns it
+void ntHostSetSampleRate(uint32_t sampleRate);
+void ntHostSetMaxFramesPerStep(uint32_t frames);
+
+struct NtHostInstance {
+    const _NT_factory* factory = nullptr;
+    _NT_algorithmRequirements req = {};
+    std::vector<uint8_t> sram, dram, dtc, itc;
+    std::vector<int16_t> values;
+    _NT_algorithm* alg = nullptr;
+};
+
+// Construct with every parameter at its default, then announce each one
+// through parameterChanged() as the module does after loading a preset.
+// The first instance of a factory also sets up its static memory, which
+// every later instance in the process shares.
+bool ntHostCreate(NtHostInstance& inst, const _NT_factory* factory, const int32_t* specifications = nullptr);
+
+// Parameter lookup by display name (case-sensitive), -1 if unknown
+int ntHostFindParameter(const NtHostInstance& inst, const char* name);
+
+void ntHostSetParameter(NtHostInstance& inst, int p, int16_t value);
+
+// busFrames holds kNtHostNumBusses × numFrames samples; numFrames % 4 == 0
+void ntHostStep(NtHostInstance& inst, float* busFrames, int numFrames);
+
+// Screen text recorded by NT_drawText since the last clear
+void ntHostClearScreen();
+void ntHostDumpScreen(FILE* out);